@@ -9,14 +9,25 @@
 #include <cmath>
 #include <ctime>
 #include <fstream>
-#include <future>
-#include <thread>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <sstream>
 
 #include "algorithm.hpp"
+#include "../budget/budget.hpp"
 #include "../individual/individual.hpp"
 #include "../logging/logging.hpp"
+#include "../metrics/metrics.hpp"
 #include "../options/options.hpp"
+#include "../problem/ant.hpp"
+#include "../problem/regression.hpp"
+#include "../profile/profile.hpp"
 #include "../random_generator/random_generator.hpp"
+#include "../surrogate/surrogate.hpp"
+#include "../telemetry/telemetry.hpp"
+#include "../termination/termination.hpp"
+#include "../topology/topology.hpp"
 
 namespace algorithm
 {
@@ -25,24 +36,10 @@ namespace algorithm
   using options::Options;
   using namespace random_generator;
 
-  // Prototypes
-  vector<Individual>
-  new_population(const Options& opts);
-
-  vector<Individual>
-  new_offspring(vector<Individual>& pop, int gen, const Options& opts);
-
-  const Individual&
-  select(int size, int start, int stop, const vector<Individual>& pop);
-
-  void
-  recombination(vector<Individual>& offspring, int gen, const Options& opts);
-
-  // Definitions
-
   // Returns true if "a" is ordered before "b", i.e. more fit
-  bool
-  compare_fitness::operator()(const Individual& a, const Individual& b)
+  template<typename Problem> bool
+  compare_fitness::operator()(const Individual<Problem>& a,
+			      const Individual<Problem>& b) const
   {
     return std::isnormal(a.get_fitness())
       ? (a.get_fitness() > b.get_fitness()) : false;
@@ -51,22 +48,24 @@ namespace algorithm
   /* Create an initial population using "ramped half-and-half" (half
      full trees, half randomly grown trees, all to random depths
      between 0 and maximum depth). */
-  vector<Individual>
+  template<typename Problem> vector<Individual<Problem>>
   new_population(const Options& opts)
   {
-    vector<Individual> pop;
+    vector<Individual<Problem>> pop;
     pop.reserve(opts.pop_size);
 
+    METRICS_TIME(evaluation); // Individuals are evaluated on creation.
     generate_n(back_inserter(pop), opts.pop_size, [&opts]
-	       { return Individual{opts}; });
+	       { return Individual<Problem>{opts}; });
+    termination::evaluated(pop.size());
 
     return pop;
   }
 
   /* Return best candidate from size number of contestants randomly
      drawn from population.  Assume population is sorted. */
-  const Individual&
-  select(int size, int start, int stop, const vector<Individual>& pop)
+  template<typename Problem> const Individual<Problem>&
+  select(int size, int start, int stop, const vector<Individual<Problem>>& pop)
   {
     int_dist dist{start, stop - 1}; // closed interval
     vector<unsigned int> group;
@@ -80,11 +79,12 @@ namespace algorithm
     return pop[*min_element(begin(group), end(group))];
   }
 
-  void
-  breed_pups(vector<Individual>::iterator& parent, int gen, const Options& opts)
+  template<typename Problem> void
+  breed_pups(typename vector<Individual<Problem>>::iterator& parent, int gen,
+	     const Options& opts)
   {
     // Brood selection, see Banzhaf section 6.5.1
-    vector<Individual> brood;
+    vector<Individual<Problem>> brood;
     brood.reserve(opts.brood_count * opts.crossover_size);
 
     // Create N copies of the pair
@@ -93,26 +93,64 @@ namespace algorithm
 	brood.push_back(*parent);
 	brood.push_back(*next(parent));
       }
+    METRICS_COUNT(copies, brood.size());
 
     // Crossover each pair of pups
     for (auto pup = begin(brood); pup != end(brood); advance(pup, 2))
       { crossover(opts.internals_chance, *pup, *next(pup)); }
 
-    /* Evaluate pups with fewer ticks: minimum plus [0, 1] * 600
-       where 0 is the first generation and 1 is the final
-       generation (thus scaling the evaluation with the run's
-       age). */
-    options::Map map = opts.map;
-    float scale = static_cast<float>(gen) / opts.generations;;
-    int min = 0.1 * map.max_ticks;
-    map.max_ticks = min + scale * (map.max_ticks - min);
+    /* Once the surrogate is fit, evaluate only the pups it ranks
+       highest (at least the two to survive) or samples. */
+    surrogate::Model* model = surrogate::model();
+    if (model and model->ready())
+      {
+	const float fitness[] = {parent->get_fitness(), next(parent)->get_fitness()};
+	vector<double> predictions;
+	predictions.reserve(brood.size());
+	for (std::size_t i{0}; i < brood.size(); ++i)
+	  {
+	    predictions.push_back(model->predict(surrogate::features(brood[i],
+								     fitness[i % 2])));
+	  }
+	const vector<surrogate::Verdict> verdicts = model->screen(predictions, 2);
+	vector<Individual<Problem>> screened;
+	screened.reserve(brood.size());
+	for (std::size_t i{0}; i < brood.size(); ++i)
+	  if (verdicts[i] != surrogate::Verdict::rejected)
+	    { screened.push_back(std::move(brood[i])); }
+	brood.swap(screened);
+      }
+
+    const budget::Limits limits = budget::limits(opts);
+    auto over = [&limits](const Individual<Problem>& pup)
+      { return pup.get_depth() > limits.depth or pup.get_total() > limits.size; };
+
+    /* Evaluate pups on less of the problem (for the ant, fewer
+       ticks), scaled with the run's age. */
+    const float scale = static_cast<float>(gen) / opts.generations;
+    const auto& cases = Problem::brood(Problem::cases(opts), scale);
+
+    /* Only the best two pups survive, so when racing, a pup need only
+       be evaluated until it cannot beat the second best so far. */
+    const float lowest = -std::numeric_limits<float>::infinity();
+    float first{lowest}, second{lowest};
     for (auto& pup : brood)
-      { pup.evaluate(map, opts.penalty); }
+      {
+	{
+	  METRICS_TIME(evaluation);
+	  pup.evaluate(cases, opts, opts.racing ? second : lowest);
+	}
+	termination::evaluated();
+	if (over(pup))
+	  { continue; }
+	if (pup.get_fitness() > first)
+	  { second = first; first = pup.get_fitness(); }
+	else if (pup.get_fitness() > second)
+	  { second = pup.get_fitness(); }
+      }
 
-    // Kill pups with too great a depth.
-    auto remove = [&opts, &brood](const Individual& a)
-      { return (a.get_depth() > opts.depth_limit); };
-    brood.erase(remove_if(begin(brood), end(brood), remove), end(brood));
+    // Kill pups with too great a depth or size.
+    brood.erase(remove_if(begin(brood), end(brood), over), end(brood));
 
     // Replace parents with best pair of brood if available.
     sort(begin(brood), end(brood), compare_fitness());
@@ -122,8 +160,9 @@ namespace algorithm
       { *next(parent) = std::move(*next(begin(brood))); }
   }
 
-  void
-  recombination(vector<Individual>& offspring, int gen, const Options& opts)
+  template<typename Problem> void
+  recombination(vector<Individual<Problem>>& offspring, int gen,
+		const Options& opts)
   {
     bool_dist crossover_dist{opts.crossover_chance};
     for (auto iter = begin(offspring); iter != end(offspring); advance(iter, 2))
@@ -133,118 +172,371 @@ namespace algorithm
 	    if (opts.brood_count == 0)
 	      { crossover(opts.internals_chance, *iter, *next(iter)); }
 	    else
-	      { breed_pups(iter, gen, opts); }
+	      { breed_pups<Problem>(iter, gen, opts); }
 	  }
       }
   }
 
   /* Return new offspring population.  The pop is not passed const as
      it must be sorted. */
-  vector<Individual>
-  new_offspring(vector<Individual>& pop, int gen, const Options& opts)
+  template<typename Problem> vector<Individual<Problem>>
+  new_offspring(vector<Individual<Problem>>& pop, int gen, const Options& opts)
   {
     // Select parents for children.
-    vector<Individual> offspring;
+    vector<Individual<Problem>> offspring;
     offspring.reserve(opts.pop_size);
+    vector<const Individual<Problem>*> parents; // Of each child, in pop.
+    parents.reserve(opts.pop_size);
+
+    // The surrogate's features, predictions and verdicts of each child.
+    surrogate::Model* model = surrogate::model();
+    vector<surrogate::Features> features;
+    vector<double> predictions;
+    vector<surrogate::Verdict> verdicts(opts.pop_size,
+					surrogate::Verdict::ranked);
+
+    /* Vary the population: select, recombine and mutate children
+       (evaluated afterwards, so each phase can be profiled). */
+    {
+      profile::Scope scope{profile::Phase::variation};
+
+      /* Implements over-selection.  80% drawn from a fitter group of
+	 320, the other 20% drawn from the weaker group (past the first
+	 sorted 320).  See Eiben section 6.6. */
+      {
+	METRICS_TIME(sort);
+	sort(begin(pop), end(pop), compare_fitness());
+      }
+      bool_dist select_dist(opts.over_select_chance);
+      auto over_select = [&opts, &pop, &select_dist]
+	() -> const Individual<Problem>&
+	{
+	  if (select_dist(rg.engine))
+	    { return select(opts.tourney_size, 0, opts.fit_size, pop); }
+	  else
+	    { return select(opts.tourney_size, opts.fit_size, opts.pop_size, pop); }
+	};
 
-    /* Implements over-selection.  80% drawn from a fitter group of
-       320, the other 20% drawn from the weaker group (past the first
-       sorted 320).  See Eiben section 6.6. */
-    sort(begin(pop), end(pop), compare_fitness());
-    bool_dist select_dist(opts.over_select_chance);
-    auto over_select = [&opts, &pop, &select_dist]
       {
-	if (select_dist(rg.engine))
-	  { return select(opts.tourney_size, 0, opts.fit_size, pop); }
-	else
-	  { return select(opts.tourney_size, opts.fit_size, opts.pop_size, pop); }
-      };
+	METRICS_TIME(selection);
+	generate_n(back_inserter(parents), opts.pop_size,
+		   [&over_select] { return &over_select(); });
+	for (const auto parent : parents)
+	  { offspring.push_back(*parent); }
+	METRICS_COUNT(copies, offspring.size());
+      }
 
-    generate_n(back_inserter(offspring), opts.pop_size, over_select);
+      // Binary crossover if enabled.
+      if (opts.crossover_size == 2)
+	{
+	  METRICS_TIME(crossover);
+	  recombination(offspring, gen, opts);
+	}
 
-    // Binary crossover if enabled.
-    if (opts.crossover_size == 2)
-      { recombination(offspring, gen, opts); }
+      // Mutate children.
+      bool_dist mutate_dist(opts.mutate_chance);
+      for (auto& child : offspring)
+	if (mutate_dist(rg.engine))
+	  {
+	    METRICS_TIME(mutation);
+	    child.mutate(opts.min_depth, opts.max_depth, opts.grow_chance);
+	  }
 
-    // Mutate and evaluate children.
-    bool_dist mutate_dist(opts.mutate_chance);
-    for (auto& child : offspring)
+      /* Replace children over the depth or size limit (tightened near
+	 the memory limit) with newly selected parents: the first within
+	 the limits (as parents chosen under looser limits may not be)
+	 of as many as a tournament, else the smallest. */
       {
-	if (mutate_dist(rg.engine))
-	  { child.mutate(opts.min_depth, opts.max_depth, opts.grow_chance); }
+	METRICS_TIME(selection);
+	const budget::Limits limits = budget::limits(opts);
+	auto over = [&limits](const Individual<Problem>& child)
+	  {
+	    return child.get_depth() > limits.depth
+	      or child.get_total() > limits.size;
+	  };
+	long replacements{0};
+	for (std::size_t i{0}; i < offspring.size(); ++i)
+	  if (over(offspring[i]))
+	    {
+	      const Individual<Problem>* smallest = &over_select();
+	      for (int t{1}; t < opts.tourney_size and over(*smallest); ++t)
+		{
+		  const Individual<Problem>& parent = over_select();
+		  if (parent.get_total() < smallest->get_total())
+		    { smallest = &parent; }
+		}
+	      offspring[i] = *smallest;
+	      parents[i] = smallest;
+	      ++replacements;
+	    }
+	budget::replaced(replacements);
+	METRICS_COUNT(copies, replacements);
+      }
 
-	child.evaluate(opts.map, opts.penalty); // Evaluate all children
+      /* Once the surrogate is fit, screen the children by their
+	 predicted fitness, replacing each it rejects with (a copy of)
+	 its parent, already evaluated. */
+      if (model)
+	{
+	  METRICS_TIME(selection);
+	  for (std::size_t i{0}; i < offspring.size(); ++i)
+	    {
+	      features.push_back(surrogate::features(offspring[i],
+						     parents[i]->get_fitness()));
+	      if (model->ready())
+		{ predictions.push_back(model->predict(features.back())); }
+	    }
+	  if (model->ready())
+	    { verdicts = model->screen(predictions); }
+	  long rejected{0};
+	  for (std::size_t i{0}; i < offspring.size(); ++i)
+	    if (verdicts[i] == surrogate::Verdict::rejected)
+	      {
+		offspring[i] = *parents[i];
+		++rejected;
+	      }
+	  METRICS_COUNT(copies, rejected);
+	}
+    }
+
+    /* When racing, children are only evaluated until they provably
+       cannot make the fitter group of their parents' generation. */
+    const float threshold = opts.racing
+      ? pop[opts.fit_size - 1].get_fitness()
+      : -std::numeric_limits<float>::infinity();
+
+    /* Evaluate all children (but those the surrogate rejected) as a
+       batch, which the problem may interleave, and train the surrogate
+       on them. */
+    profile::Scope scope{profile::Phase::evaluation};
+    vector<Individual<Problem>*> batch;
+    batch.reserve(offspring.size());
+    for (std::size_t i{0}; i < offspring.size(); ++i)
+      if (verdicts[i] != surrogate::Verdict::rejected)
+	{ batch.push_back(&offspring[i]); }
+    {
+      METRICS_TIME(evaluation);
+      Problem::evaluate(batch, Problem::cases(opts), opts, threshold);
+    }
+    for (std::size_t i{0}; i < offspring.size(); ++i)
+      {
+	if (verdicts[i] == surrogate::Verdict::rejected)
+	  { continue; }
+	const auto& child = offspring[i];
+	profile::evaluated(child.get_total());
+	termination::evaluated();
+	if (model)
+	  {
+	    if (model->ready())
+	      { model->scored(predictions[i], child.get_fitness(), verdicts[i]); }
+	    model->observe(features[i], child.get_fitness());
+	  }
       }
+    if (model)
+      { model->update(gen); }
     return offspring;
   }
 
   /* The actual genetic algorithm applied which (hopefully) produces a
      well-fit expression for a given dataset. */
-  const result_t
-  genetic(const std::time_t& time, int trial, const Options& opts)
+  template<typename Problem> const result_t<Problem>
+  genetic(const std::time_t& time, int trial, const Options& shared,
+	  termination::Run& run, const Monitor& monitor)
   {
-    // Start logging
-    std::ofstream log;
+    /* When pinning, the trial's thread gets its own core, and its own
+       copy of the maps or samples, so they (like everything else it
+       allocates from here, through its own malloc arena) are first
+       touched, and so placed, on its node. */
+    topology::Pin pin{shared.pin};
+    std::unique_ptr<const Options> local;
+    if (pin.pinned())
+      { local.reset(new Options{shared.local()}); }
+    const Options& opts = local ? *local : shared;
+
+    // Start logging, handing the open log to the logger thread.
+    std::shared_ptr<logging::Channel> log;
     if (opts.verbosity > 0)
       {
-	logging::open_log(log, time, trial, opts.logs_dir);
-	logging::start_log(log, time, opts);
+	std::ofstream file;
+	const bool binary{opts.log_format == "binary"};
+	if (binary)
+	  { logging::binary::start(file, time, trial, opts); }
+	else
+	  {
+	    logging::open_log(file, time, trial, opts.logs_dir);
+	    logging::start_log(file, time, opts);
+	  }
+	log = logging::Logger::instance().open(std::move(file), binary);
       }
 
+#ifdef ENABLE_METRICS
+    // Write phase times and work counts per generation as JSON Lines.
+    std::ofstream metrics_log;
+    if (opts.verbosity > 0)
+      { logging::open_log(metrics_log, time, trial, opts.logs_dir, ".jsonl"); }
+    metrics::current() = metrics::Totals{};
+    metrics::Totals previous;
+#endif
+
     // Begin timing algorithm.
     auto start = std::chrono::system_clock::now();
 
+    // Stop when any criterion is met (counting evaluations from here).
+    termination::Trial termination{opts, run};
+
+    // Publish each generation's statistics live, if asked to.
+    telemetry::Publisher publisher{opts.telemetry, trial};
+
+    /* Account for the nodes of the trial's populations: both
+       generations', held together while breeding. */
+    budget::Account account{opts, sizeof(individual::Node<Problem>)};
+    auto nodes = [](const vector<Individual<Problem>>& population)
+      {
+	return std::accumulate(begin(population), end(population), 0L,
+			       [](long a, const Individual<Problem>& b)
+			       { return a + b.get_total(); });
+      };
+
+    // Screen children by a surrogate model of fitness, if asked to.
+    surrogate::Model model{opts};
+
+    // Count hardware events of this trial's phases if profiling.
+    std::unique_ptr<profile::Session> session;
+    if (opts.profile)
+      { session.reset(new profile::Session); }
+
     // Create initial population.
-    vector<Individual> pop = new_population(opts);
-    Individual best;
+    vector<Individual<Problem>> pop;
+    {
+      profile::Scope scope{profile::Phase::evaluation};
+      pop = new_population<Problem>(opts);
+      for (const auto& i : pop)
+	{ profile::evaluated(i.get_total()); }
+    }
+    account.update(2 * nodes(pop), 0); // As breeding doubles it.
+    Individual<Problem> best;
 
     // Run algorithm to termination.
-    for (int g{0}; g < opts.generations; ++g)
+    for (int g{0}; ; ++g)
       {
 	// Find best Individual of current population.
-	best = *min_element(begin(pop), end(pop), compare_fitness());
+	{
+	  METRICS_TIME(elitism);
+	  best = *min_element(begin(pop), end(pop), compare_fitness());
+	  METRICS_COUNT(copies, 1);
+	}
+
+	/* Queue this generation's statistics for the logger thread,
+	   publish them, and hand them to the monitor; the monitor or a
+	   telemetry client may stop the trial. */
+	if (log or monitor or not opts.telemetry.empty())
+	  {
+	    METRICS_TIME(logging);
+	    const logging::Record record = logging::summarize(g, best, pop);
+	    if (log)
+	      { log->push(record); }
+	    publisher.publish(record, termination.evaluations_so_far(),
+			      record.avg_size * pop.size()
+			      * sizeof(individual::Node<Problem>));
+	    if ((monitor and not monitor(trial, record)) or publisher.stopped())
+	      { termination.stop(); }
+	  }
 
-	// Launch background logging thread.
-	auto log_thread =
-	  async(std::launch::async, logging::log_info,
-		opts.verbosity, opts.logs_dir, time, trial, g, best, pop);
+	// Stop after this generation if any criterion is met.
+	if (termination.done(g, best.get_score(), best.get_fitness()))
+	  { break; }
 
 	// Create replacement population.
-	vector<Individual> offspring = new_offspring(pop, g, opts);
+	vector<Individual<Problem>> offspring = new_offspring(pop, g, opts);
+	account.update(nodes(pop) + nodes(offspring), g);
 
 	// Perform elitism replacement of random individuals.
-	int_dist dist{0, opts.pop_size - 1};
-	for (int e{0}; e < opts.elitism_size; ++e)
-	  { offspring[dist(rg.engine)] = best; }
+	{
+	  METRICS_TIME(elitism);
+	  int_dist dist{0, opts.pop_size - 1};
+	  for (int e{0}; e < opts.elitism_size; ++e)
+	    { offspring[dist(rg.engine)] = best; }
+	  METRICS_COUNT(copies, opts.elitism_size);
+	}
 
 	// Replace current population with offspring.
 	pop = move(offspring);
 
-	// Sync with background logging thread.
-	log_thread.wait();
+#ifdef ENABLE_METRICS
+	if (metrics_log)
+	  {
+	    const metrics::Totals totals = metrics::current();
+	    metrics_log << metrics::json(trial, g, totals - previous) << '\n';
+	    previous = totals;
+	  }
+#endif
       }
 
+#ifdef ENABLE_METRICS
+    // Generation -1 holds the trial's totals.
+    if (metrics_log)
+      { metrics_log << metrics::json(trial, -1, metrics::current()) << '\n'; }
+#endif
+
     // End timing algorithm.
     auto stop = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsed_seconds = stop - start;
     auto stop_time = std::chrono::system_clock::to_time_t(stop);
 
     // Log time information.
-    if (opts.verbosity > 0)
+    if (log)
       {
-	logging::open_log(log, time, trial, opts.logs_dir);
-	log << best.print() << best.print_formula()
-	    << "# Finished computation @ " << ctime(&stop_time)
-	    << "# Elapsed time: " << elapsed_seconds.count() << "s\n";
-	log.close();
+	std::stringstream footer;
+	footer << best.print() << best.print_formula()
+	       << termination.report() << account.report() << model.report()
+	       << pin.report() << publisher.report()
+	       << "# Finished computation @ " << ctime(&stop_time)
+	       << "# Elapsed time: " << elapsed_seconds.count() << "s\n";
+	if (session)
+	  { footer << session->report(); }
+	log->close(footer.str());
       }
 
-    // Log evaluation plot data of best individual.
-    std::ofstream plot;
-    logging::open_log(plot, time, trial, opts.plots_dir);
-    plot << best.evaluate(opts.map, opts.penalty, true);
-    plot.close();
+    /* Log the best individual's plot data (for the ant, its trace on
+       each map, from which the replay program rebuilds the plots),
+       unless there is no plots directory. */
+    if (not opts.plots_dir.empty())
+      {
+	std::ofstream plot;
+	logging::open_log(plot, time, trial, opts.plots_dir,
+			  Problem::extension);
+	plot << best.plot(opts);
+      }
 
     return std::make_tuple(best, elapsed_seconds);
   }
+
+  // The algorithm for each problem.
+  using problem::Ant;
+  using problem::Regression;
+
+  template bool
+  compare_fitness::operator()(const Individual<Ant>&,
+			      const Individual<Ant>&) const;
+  template vector<Individual<Ant>> new_population<Ant>(const Options&);
+  template vector<Individual<Ant>>
+  new_offspring(vector<Individual<Ant>>&, int, const Options&);
+  template const Individual<Ant>&
+  select(int, int, int, const vector<Individual<Ant>>&);
+  template const result_t<Ant>
+  genetic<Ant>(const std::time_t&, int, const Options&, termination::Run&,
+	       const Monitor&);
+
+  template bool
+  compare_fitness::operator()(const Individual<Regression>&,
+			      const Individual<Regression>&) const;
+  template vector<Individual<Regression>>
+  new_population<Regression>(const Options&);
+  template vector<Individual<Regression>>
+  new_offspring(vector<Individual<Regression>>&, int, const Options&);
+  template const Individual<Regression>&
+  select(int, int, int, const vector<Individual<Regression>>&);
+  template const result_t<Regression>
+  genetic<Regression>(const std::time_t&, int, const Options&,
+		      termination::Run&, const Monitor&);
 }
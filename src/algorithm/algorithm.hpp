@@ -9,25 +9,55 @@
 
 #include <chrono>
 #include <ctime>
+#include <functional>
 #include <tuple>
+#include <vector>
 
 // Forward declarations
 namespace options { struct Options; }
-namespace individual { class Individual; }
+namespace individual { template<typename Problem> class Individual; }
+namespace termination { class Run; }
+namespace logging { struct Record; }
 
+/* The genetic algorithm, generic in the problem (see problem/ant.hpp)
+   and instantiated for each in algorithm.cpp. */
 namespace algorithm
 {
   // Functor to compare two individuals by fitness
   struct compare_fitness
   {
-    bool
-    operator()(const individual::Individual&, const individual::Individual&);
+    template<typename Problem> bool
+    operator()(const individual::Individual<Problem>&,
+	       const individual::Individual<Problem>&) const;
   };
 
-  typedef std::tuple<individual::Individual, std::chrono::duration<double>> result_t;
+  template<typename Problem>
+  using result_t = std::tuple<individual::Individual<Problem>,
+			      std::chrono::duration<double>>;
 
-  const result_t
-  genetic(const std::time_t&, int, const options::Options&);
+  /* Called in-process with a trial's number and each generation's
+     statistics (as logged), from the trial's thread; returning false
+     stops the trial. */
+  typedef std::function<bool(int, const logging::Record&)> Monitor;
+
+  // Generation steps, exposed for benchmarking.
+  template<typename Problem>
+  std::vector<individual::Individual<Problem>>
+  new_population(const options::Options&);
+
+  template<typename Problem>
+  std::vector<individual::Individual<Problem>>
+  new_offspring(std::vector<individual::Individual<Problem>>&, int,
+		const options::Options&);
+
+  template<typename Problem>
+  const individual::Individual<Problem>&
+  select(int, int, int, const std::vector<individual::Individual<Problem>>&);
+
+  template<typename Problem>
+  const result_t<Problem>
+  genetic(const std::time_t&, int, const options::Options&, termination::Run&,
+	  const Monitor& = nullptr);
 }
 
 #endif /* _ALGORITHM_H_ */
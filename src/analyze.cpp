@@ -0,0 +1,417 @@
+/* analyze.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Aggregates the trial logs of many runs into per-generation statistics.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <boost/program_options.hpp>
+
+#include "logging/logging.hpp"
+#include "options/options.hpp"
+
+using std::string;
+using std::vector;
+
+// One trial's log: its run (the Unix time prefix), records and time.
+struct Trial
+{
+  string run;
+  vector<logging::Record> records;
+  double seconds; // Elapsed, or 0 if it never finished.
+};
+
+// Runs work(i) for every i below count on a thread per core.
+template<typename Work> void
+parallel(std::size_t count, Work work)
+{
+  const unsigned long hardware_threads = std::thread::hardware_concurrency();
+  const std::size_t workers = std::min<std::size_t>(
+    hardware_threads != 0 ? hardware_threads : 2, count);
+
+  std::atomic<std::size_t> next{0};
+  auto worker = [&next, count, &work]
+    {
+      for (std::size_t i = next++; i < count; i = next++)
+	{ work(i); }
+    };
+
+  vector<std::thread> pool;
+  for (std::size_t w{0}; w < workers; ++w)
+    { pool.emplace_back(worker); }
+  for (auto& thread : pool)
+    { thread.join(); }
+}
+
+// The elapsed time of a footer, or 0 if it has none.
+double
+elapsed(const char* begin, const char* end)
+{
+  const string prefix{"# Elapsed time: "};
+  const char* found = std::search(begin, end, prefix.begin(), prefix.end());
+  if (found == end)
+    { return 0; }
+  const string rest{found + prefix.size(), std::find(found, end, '\n')};
+  return std::strtod(rest.c_str(), nullptr);
+}
+
+/* Parses a mapped text log in one pass: comment lines are its header
+   and footer, the rest one generation's record each. */
+Trial
+read_text(const options::Mapping& file)
+{
+  Trial trial{"", {}, 0};
+  const char* c = file.data;
+  const char* const end = file.data + file.size;
+  const char* footer = end;
+  while (c < end)
+    {
+      const char* eol = std::find(c, end, '\n');
+      if (*c == '#')
+	{
+	  if (not trial.records.empty() and footer == end)
+	    { footer = c; }
+	}
+      else if (eol != c and footer == end) // Not a summary after it.
+	{
+	  // Numbers end at the newline, but the last line may have none.
+	  const string last{eol == end ? string{c, eol} : ""};
+	  char* number = const_cast<char*>(last.empty() ? c : last.c_str());
+	  logging::Record r;
+	  r.generation = std::strtol(number, &number, 10);
+	  r.score = std::strtol(number, &number, 10);
+	  r.best_fitness = std::strtof(number, &number);
+	  r.avg_fitness = std::strtof(number, &number);
+	  r.best_size = std::strtol(number, &number, 10);
+	  r.avg_size = std::strtof(number, &number);
+	  r.best_depth = std::strtol(number, &number, 10);
+	  r.avg_depth = std::strtof(number, &number);
+	  trial.records.push_back(r);
+	}
+      c = eol + 1;
+    }
+  trial.seconds = elapsed(footer, end);
+  return trial;
+}
+
+Trial
+read_binary(const options::Mapping& file, const string& filename)
+{
+  const auto log = logging::binary::view(filename, file.data, file.size);
+  Trial trial{"", {log.records, log.records + log.count}, 0};
+  trial.seconds = elapsed(log.footer.data(), log.footer.data()
+			  + log.footer.size());
+  return trial;
+}
+
+// True if the text file starts as a trial log (not a trials summary).
+bool
+trial_log(const string& path)
+{
+  const string header{"# running a Genetic Program"};
+  std::ifstream file{path};
+  string start(header.size(), '\0');
+  file.read(&start[0], start.size());
+  return file and start == header;
+}
+
+/* Finds the trial logs (<time>_<trial>.dat or .bin) under each path,
+   recursively, preferring a binary log to the text log dumped from
+   it.  The summary of a run's trials is <time>_0.dat, which is also
+   the trial log of a single trial, so text logs are told apart by
+   their header. */
+vector<string>
+find_logs(const vector<string>& paths)
+{
+  std::map<string, string> logs; // By name without extension.
+  vector<string> pending{paths};
+  while (not pending.empty())
+    {
+      const string path = pending.back();
+      pending.pop_back();
+
+      struct stat status;
+      if (stat(path.c_str(), &status) != 0)
+	{ throw std::runtime_error{"File " + path + " could not be read!"}; }
+      if (S_ISDIR(status.st_mode))
+	{
+	  if (DIR* directory = opendir(path.c_str()))
+	    {
+	      while (const dirent* entry = readdir(directory))
+		if (entry->d_name[0] != '.')
+		  { pending.push_back(path + "/" + entry->d_name); }
+	      closedir(directory);
+	    }
+	  continue;
+	}
+
+      const string name = path.substr(path.rfind('/') + 1);
+      unsigned long time, trial;
+      char extension[4];
+      int length{0};
+      if (std::sscanf(name.c_str(), "%lu_%lu.%3s%n", &time, &trial,
+		      extension, &length) != 3
+	  or static_cast<std::size_t>(length) != name.size()
+	  or (string{extension} != "dat" and string{extension} != "bin")
+	  or (string{extension} == "dat" and not trial_log(path)))
+	{ continue; }
+
+      const string stem = path.substr(0, path.size() - 4);
+      if (string{extension} == "bin" or logs.count(stem) == 0)
+	{ logs[stem] = path; }
+    }
+
+  vector<string> found;
+  for (const auto& log : logs)
+    { found.push_back(log.second); }
+  return found;
+}
+
+// The q-quantile of sorted values, interpolating between neighbours.
+template<typename T> double
+quantile(const vector<T>& sorted, double q)
+{
+  const double position = q * (sorted.size() - 1);
+  const std::size_t below = position;
+  const std::size_t above = std::min(below + 1, sorted.size() - 1);
+  return sorted[below] + (position - below) * (sorted[above] - sorted[below]);
+}
+
+int
+main(int argc, char* argv[])
+{
+  using namespace boost::program_options;
+
+  vector<string> paths;
+  string output;
+  int target;
+
+  options_description description{"Allowed options"};
+  description.add_options()
+    ("help,h", "produce help message")
+    ("input,i", value<vector<string>>(&paths)->required(),
+     "set the logs, or directories searched for them, to analyze")
+    ("output,o", value<string>(&output)->default_value("analysis.dat"),
+     "set the file to write the statistics to")
+    ("target", value<int>(&target)->default_value(0),
+     "set the score counted as success (0 for the best any trial reached)");
+
+  positional_options_description positionals;
+  positionals.add("input", -1);
+
+  variables_map variables_map;
+  try
+    {
+      store(command_line_parser(argc, argv).options(description)
+	    .positional(positionals).run(), variables_map);
+      if (variables_map.count("help"))
+	{
+	  std::cout << "Usage: antgp-analyze <logs directory or log>... [-o <file>]\n\n"
+		    << description << std::endl;
+	  return EXIT_SUCCESS;
+	}
+      notify(variables_map);
+    }
+  catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  // Map and parse every trial's log in parallel.
+  vector<string> logs;
+  try
+    { logs = find_logs(paths); }
+  catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  vector<Trial> trials(logs.size());
+  vector<string> errors(logs.size());
+  parallel(logs.size(), [&](std::size_t i)
+	   {
+	     try
+	       {
+		 const options::Mapping file{logs[i]};
+		 const bool binary = logs[i].compare(logs[i].size() - 4, 4,
+						     ".bin") == 0;
+		 trials[i] = binary ? read_binary(file, logs[i])
+		   : read_text(file);
+	       }
+	     catch (const std::runtime_error& e)
+	       { errors[i] = e.what(); }
+	     const string name = logs[i].substr(logs[i].rfind('/') + 1);
+	     trials[i].run = name.substr(0, name.find('_'));
+	   });
+
+  // Skip unreadable or empty logs (say, of a trial just started).
+  std::set<string> runs;
+  vector<Trial> read;
+  for (std::size_t i{0}; i < logs.size(); ++i)
+    if (not errors[i].empty())
+      { std::cerr << "Skipped: " << errors[i] << '\n'; }
+    else if (not trials[i].records.empty())
+      {
+	runs.insert(trials[i].run);
+	read.push_back(std::move(trials[i]));
+      }
+  if (read.empty())
+    {
+      std::cerr << "No trial logs found!\n";
+      return EXIT_FAILURE;
+    }
+
+  /* Each trial's best score so far per generation, and so the
+     generation it reached the target (or -1). */
+  std::size_t generations{0};
+  for (const auto& trial : read)
+    { generations = std::max(generations, trial.records.size()); }
+  if (target == 0)
+    for (const auto& trial : read)
+      for (const auto& record : trial.records)
+	{ target = std::max(target, record.score); }
+  vector<vector<int>> bests(read.size());
+  vector<int> reached(read.size(), -1);
+  parallel(read.size(), [&](std::size_t t)
+	   {
+	     int best{0};
+	     for (const auto& record : read[t].records)
+	       {
+		 best = std::max(best, record.score);
+		 bests[t].push_back(best);
+		 if (reached[t] < 0 and best >= target)
+		   { reached[t] = bests[t].size() - 1; }
+	       }
+	   });
+
+  /* Statistics of every generation across the trials, with finished
+     trials' last records carried forward. */
+  struct Statistics
+  {
+    int running;
+    double mean, median, q25, q75;
+    int min, max;
+    double success, best_fitness, avg_fitness, avg_size;
+  };
+  vector<Statistics> statistics(generations);
+  parallel(generations, [&](std::size_t g)
+	   {
+	     Statistics& s = statistics[g];
+	     vector<int> scores;
+	     scores.reserve(read.size());
+	     s = Statistics{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+	     for (std::size_t t{0}; t < read.size(); ++t)
+	       {
+		 const auto& records = read[t].records;
+		 const std::size_t last = std::min(g, records.size() - 1);
+		 s.running += g < records.size();
+		 scores.push_back(bests[t][last]);
+		 s.success += reached[t] >= 0
+		   and static_cast<std::size_t>(reached[t]) <= g;
+		 s.best_fitness += records[last].best_fitness;
+		 s.avg_fitness += records[last].avg_fitness;
+		 s.avg_size += records[last].avg_size;
+	       }
+	     std::sort(begin(scores), end(scores));
+	     const double n = read.size();
+	     for (const int score : scores)
+	       { s.mean += score / n; }
+	     s.median = quantile(scores, 0.5);
+	     s.q25 = quantile(scores, 0.25);
+	     s.q75 = quantile(scores, 0.75);
+	     s.min = scores.front();
+	     s.max = scores.back();
+	     s.success /= n;
+	     s.best_fitness /= n;
+	     s.avg_fitness /= n;
+	     s.avg_size /= n;
+	   });
+
+  /* Generations and seconds to the target of the trials reaching it,
+     the seconds estimated from their elapsed times. */
+  vector<int> to_target;
+  vector<double> seconds;
+  for (std::size_t t{0}; t < read.size(); ++t)
+    if (reached[t] >= 0)
+      {
+	to_target.push_back(reached[t] + 1);
+	if (read[t].seconds > 0)
+	  {
+	    seconds.push_back(read[t].seconds * (reached[t] + 1)
+			      / read[t].records.size());
+	  }
+      }
+  std::sort(begin(to_target), end(to_target));
+  std::sort(begin(seconds), end(seconds));
+
+  std::ofstream file{output};
+  if (not file)
+    {
+      std::cerr << "File " << output << " could not be written!\n";
+      return EXIT_FAILURE;
+    }
+
+  using std::setw;
+  const int width{10};
+  file << "# analysis of " << read.size() << " trials of " << runs.size()
+       << " runs, with a target score of " << target << "\n# success rate: "
+       << static_cast<double>(to_target.size()) / read.size() << " ("
+       << to_target.size() << " of " << read.size() << ")";
+  if (not to_target.empty())
+    {
+      double mean{0};
+      for (const int g : to_target)
+	{ mean += g / static_cast<double>(to_target.size()); }
+      file << "; generations to target: mean " << mean << ", median "
+	   << quantile(to_target, 0.5);
+    }
+  if (not seconds.empty())
+    {
+      double mean{0};
+      for (const double time : seconds)
+	{ mean += time / seconds.size(); }
+      file << "; seconds to target: mean " << mean << ", median "
+	   << quantile(seconds, 0.5);
+    }
+  file << std::left << std::setprecision(4)
+       << setw(width) << "\n# gen" << setw(width) << "running"
+       << setw(width) << "mean" << setw(width) << "median"
+       << setw(width) << "q25" << setw(width) << "q75"
+       << setw(width) << "min" << setw(width) << "max"
+       << setw(width) << "success" << setw(width) << "best fit"
+       << setw(width) << "avg fit" << setw(width) << "avg size" << '\n';
+  for (std::size_t g{0}; g < generations; ++g)
+    {
+      const Statistics& s = statistics[g];
+      file << setw(width) << g << setw(width) << s.running
+	   << setw(width) << s.mean << setw(width) << s.median
+	   << setw(width) << s.q25 << setw(width) << s.q75
+	   << setw(width) << s.min << setw(width) << s.max
+	   << setw(width) << s.success << setw(width) << s.best_fitness
+	   << setw(width) << s.avg_fitness << setw(width) << s.avg_size
+	   << '\n';
+    }
+
+  std::cout << "Analyzed " << read.size() << " trials of " << runs.size()
+	    << " runs: " << output << '\n';
+  return EXIT_SUCCESS;
+}
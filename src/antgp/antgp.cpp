@@ -0,0 +1,130 @@
+/* antgp.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for antgp namespace
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <tuple>
+
+#include "antgp.hpp"
+#include "../termination/termination.hpp"
+
+namespace antgp
+{
+  using std::string;
+  using std::vector;
+
+  /* Options of the given problem over the shared data.  Unless
+     overridden, no config file is read and nothing is logged. */
+  Options
+  configured(const Options& shared, const string& problem,
+	     vector<string> overrides)
+  {
+    for (const string option : {"config=", "verbosity=0", "plots="})
+      {
+	const string name = option.substr(0, option.find('=') + 1);
+	if (std::none_of(begin(overrides), end(overrides),
+			 [&name](const string& o)
+			 { return o.compare(0, name.size(), name) == 0; }))
+	  { overrides.push_back(option); }
+      }
+    overrides.push_back("problem=" + problem);
+
+    char name[] = "antgp";
+    char* argv[] = {name, nullptr};
+    return options::configure(1, argv, overrides, &shared);
+  }
+
+  Options
+  ant(const vector<options::Map>& maps, const vector<string>& overrides)
+  {
+    Options shared;
+    shared.maps = maps;
+    return configured(shared, "ant", overrides);
+  }
+
+  Options
+  regression(options::Samples samples, const vector<string>& overrides)
+  {
+    Options shared;
+    shared.samples = std::make_shared<const options::Samples>(std::move(samples));
+    return configured(shared, "regression", overrides);
+  }
+
+  // Runs work(i) for every i below count on a thread per core.
+  template<typename Work> void
+  parallel(int count, Work work)
+  {
+    const unsigned long hardware_threads = std::thread::hardware_concurrency();
+    const int workers = std::min<int>(
+      hardware_threads != 0 ? hardware_threads : 2, count);
+
+    std::atomic<int> next{0};
+    auto worker = [&next, count, &work]
+      {
+	for (int i = next++; i < count; i = next++)
+	  { work(i); }
+      };
+
+    vector<std::thread> pool;
+    for (int w{0}; w < workers; ++w)
+      { pool.emplace_back(worker); }
+    for (auto& thread : pool)
+      { thread.join(); }
+  }
+
+  /* Trials not yet started when one reaches the target (or the run's
+     budget is spent) are skipped, so are missing from the results. */
+  template<typename Problem> vector<Result<Problem>>
+  run(const Options& opts, const Callbacks<Problem>& callbacks)
+  {
+    const std::time_t time = std::time(nullptr);
+    termination::Run run;
+    vector<Result<Problem>> results(opts.trials);
+    vector<char> ran(opts.trials, false);
+
+    parallel(opts.trials, [&](int t)
+	     {
+	       if (t > 0 and run.done(opts) != termination::Reason::none)
+		 { return; }
+	       const auto result = algorithm::genetic<Problem>(
+		 time, t + 1, opts, run, callbacks.generation);
+	       results[t] = Result<Problem>{t + 1, std::get<0>(result),
+					    std::get<1>(result).count()};
+	       if (callbacks.trial)
+		 { callbacks.trial(results[t]); }
+	       ran[t] = true;
+	     });
+
+    vector<Result<Problem>> finished;
+    for (int t{0}; t < opts.trials; ++t)
+      if (ran[t])
+	{ finished.push_back(std::move(results[t])); }
+    return finished;
+  }
+
+  template<typename Problem> void
+  evaluate(vector<individual::Individual<Problem>>& individuals,
+	   const Options& opts)
+  {
+    parallel(individuals.size(), [&individuals, &opts](int i)
+	     { individuals[i].evaluate(Problem::cases(opts), opts); });
+  }
+
+  template vector<Result<Ant>>
+  run(const Options&, const Callbacks<Ant>&);
+
+  template vector<Result<Regression>>
+  run(const Options&, const Callbacks<Regression>&);
+
+  template void
+  evaluate(vector<individual::Individual<Ant>>&, const Options&);
+
+  template void
+  evaluate(vector<individual::Individual<Regression>>&, const Options&);
+}
@@ -0,0 +1,75 @@
+/* antgp.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for antgp namespace
+ * the in-process API of libantgp: options, runs and batch evaluation
+ */
+
+#ifndef _ANTGP_H_
+#define _ANTGP_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "algorithm/algorithm.hpp"
+#include "individual/individual.hpp"
+#include "logging/logging.hpp"
+#include "options/options.hpp"
+#include "problem/ant.hpp"
+#include "problem/regression.hpp"
+
+/* Runs searches in-process: options are built from the defaults (no
+   config file) with "name=value" overrides as on the command line,
+   over data given rather than read, and results are handed back
+   through callbacks and return values rather than log files.  Bad
+   options or data throw std::exception, though inconsistent options
+   still fail Options::validate()'s assertions. */
+namespace antgp
+{
+  using options::Options;
+  using problem::Ant;
+  using problem::Regression;
+
+  // Options of the artificial ant on the given maps.
+  Options
+  ant(const std::vector<options::Map>&,
+      const std::vector<std::string>& overrides = {});
+
+  // Options of symbolic regression on the given samples.
+  Options
+  regression(options::Samples, const std::vector<std::string>& overrides = {});
+
+  // A trial's best individual and how long the trial took.
+  template<typename Problem>
+  struct Result
+  {
+    int trial;
+    individual::Individual<Problem> best;
+    double seconds;
+  };
+
+  /* Callbacks of a run, each called from the thread of the trial
+     concerned: with each generation's statistics (as would be logged;
+     return false to stop that trial), and with each trial's result
+     as it finishes. */
+  template<typename Problem>
+  struct Callbacks
+  {
+    algorithm::Monitor generation;
+    std::function<void(const Result<Problem>&)> trial;
+  };
+
+  /* Runs the options' trials on a thread per core, returning their
+     results in trial order.  Trials log to files only if the options'
+     verbosity and plots directory ask for it. */
+  template<typename Problem> std::vector<Result<Problem>>
+  run(const Options&, const Callbacks<Problem>& = Callbacks<Problem>{});
+
+  /* Evaluates each individual on the options' maps or samples, on a
+     thread per core, updating their scores and fitnesses. */
+  template<typename Problem> void
+  evaluate(std::vector<individual::Individual<Problem>>&, const Options&);
+}
+
+#endif /* _ANTGP_H_ */
@@ -0,0 +1,238 @@
+/* bench.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Microbenchmarks of the algorithm's hot paths, taking the same
+ * options as search.  Every repetition of a benchmark is reseeded
+ * and set up identically, so its work (and allocation count) is the
+ * same across runs and commits; the fastest repetition is reported.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "algorithm/algorithm.hpp"
+#include "individual/individual.hpp"
+#include "jit/jit.hpp"
+#include "options/options.hpp"
+#include "problem/ant.hpp"
+#include "problem/regression.hpp"
+#include "random_generator/random_generator.hpp"
+
+// Count every heap allocation made by the program.
+namespace
+{
+  std::atomic<long> allocations{0};
+}
+
+void*
+operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1))
+    { return p; }
+  throw std::bad_alloc{};
+}
+
+// Not inlined, lest free() be seen to release memory from new.
+__attribute__((noinline)) void
+operator delete(void* p) noexcept
+{ std::free(p); }
+
+__attribute__((noinline)) void
+operator delete(void* p, std::size_t) noexcept
+{ std::free(p); }
+
+// Arrays too, through the same counting new and delete.
+void*
+operator new[](std::size_t size)
+{ return operator new(size); }
+
+void
+operator delete[](void* p) noexcept
+{ operator delete(p); }
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{ operator delete(p); }
+
+namespace
+{
+  using individual::Method;
+  typedef problem::Ant::Individual Individual;
+  typedef problem::Ant::Node Node;
+  using std::vector;
+  using clock = std::chrono::steady_clock;
+  using random_generator::rg;
+
+  const int width{16};
+
+  /* Repeat setup (untimed) and run (timed) at least three times,
+     until a quarter second was timed or two seconds passed in all,
+     then print the best time per operation, its rate, and
+     allocations per operation. */
+  template<typename Setup, typename Run>
+  void
+  measure(const std::string& name, long ops, Setup setup, Run run)
+  {
+    std::chrono::duration<double> total{0}, best{0};
+    long allocated{0};
+    int repetitions{0};
+    const auto begin = clock::now();
+    while (repetitions < 3
+	   or (total.count() < 0.25 and clock::now() - begin < std::chrono::seconds{2}))
+      {
+	rg.engine.seed(0);
+	setup();
+	const long before = allocations.load();
+	const auto start = clock::now();
+	run();
+	const std::chrono::duration<double> elapsed = clock::now() - start;
+	allocated += allocations.load() - before;
+	total += elapsed;
+	if (repetitions == 0 or elapsed < best)
+	  { best = elapsed; }
+	++repetitions;
+      }
+
+    const double seconds = best.count() / ops;
+    std::cout << std::left << std::setw(width) << name << std::right
+	      << std::setw(width) << std::fixed << std::setprecision(1)
+	      << seconds * 1e9
+	      << std::setw(width) << std::setprecision(0) << 1 / seconds
+	      << std::setw(width) << std::setprecision(2)
+	      << static_cast<double>(allocated) / (ops * repetitions)
+	      << std::endl;
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  options::Options opts = options::parse(argc, argv);
+
+  std::cout << std::left << std::setw(width) << "# benchmark" << std::right
+	    << std::setw(width) << "ns/op"
+	    << std::setw(width) << "ops/s"
+	    << std::setw(width) << "allocs/op" << std::endl;
+
+  /* With --problem regression, only evaluation of a seeded population
+     over every sample is timed (ops/s is rows/s). */
+  if (opts.problem == "regression")
+    {
+      vector<problem::Regression::Individual> pop;
+      measure("evaluate-rows", opts.pop_size * opts.samples->size(), [&]
+	      { pop = algorithm::new_population<problem::Regression>(opts); },
+	      [&]
+	      {
+		for (auto& i : pop)
+		  { i.evaluate(*opts.samples, opts); }
+	      });
+      return EXIT_SUCCESS;
+    }
+
+  const options::Map& map = opts.maps.front();
+  const int count{1000};
+
+  // Tree construction.
+  vector<Node> nodes;
+  nodes.reserve(count);
+  const auto clear = [&nodes] { nodes.clear(); };
+  measure("node-grow", count, clear, [&]
+	  {
+	    for (int i{0}; i < count; ++i)
+	      { nodes.emplace_back(Method::grow, opts.max_depth, 0); }
+	  });
+  measure("node-full", count, clear, [&]
+	  {
+	    for (int i{0}; i < count; ++i)
+	      { nodes.emplace_back(Method::full, opts.max_depth, 0); }
+	  });
+  nodes.clear();
+
+  // Evaluation of a fixed, seeded population (ops/s is evals/s).
+  vector<Individual> pop;
+  const auto populate = [&] { pop = algorithm::new_population<problem::Ant>(opts); };
+  const vector<options::Map> single{map};
+  measure("evaluate", opts.pop_size, populate, [&]
+	  {
+	    for (auto& i : pop)
+	      { i.evaluate(single, opts); }
+	  });
+  if (jit::supported())
+    {
+      options::Options compiled = opts;
+      compiled.jit_threshold = 1;
+      measure("evaluate-jit", opts.pop_size * opts.maps.size(), [&]
+	      { pop = algorithm::new_population<problem::Ant>(compiled); }, [&]
+	      {
+		for (auto& i : pop)
+		  { i.evaluate(compiled.maps, compiled); }
+	      });
+    }
+
+  // Map copying (with its visited set) and a scripted walk.
+  vector<options::Map> copies;
+  copies.reserve(count);
+  measure("map-copy", count, [&copies] { copies.clear(); }, [&]
+	  {
+	    for (int i{0}; i < count; ++i)
+	      { copies.push_back(map); }
+	  });
+  copies.clear();
+  options::Map walker;
+  measure("map-tick", map.max_ticks, [&] { walker = map; }, [&walker]
+	  {
+	    for (int i{0}; walker.active(); ++i)
+	      {
+		if (walker.look() or i % 4 == 0)
+		  { walker.forward(); }
+		else
+		  { walker.right(); }
+	      }
+	  });
+
+  // Genetic operators on a seeded population.
+  measure("crossover", opts.pop_size / 2, populate, [&]
+	  {
+	    for (auto i = begin(pop); i + 1 < end(pop); i += 2)
+	      { crossover(opts.internals_chance, *i, *(i + 1)); }
+	  });
+  measure("mutate", opts.pop_size, populate, [&]
+	  {
+	    for (auto& i : pop)
+	      { i.mutate(opts.min_depth, opts.max_depth, opts.grow_chance); }
+	  });
+  const auto sorted = [&]
+    {
+      populate();
+      sort(begin(pop), end(pop), algorithm::compare_fitness());
+    };
+  measure("select", count * 10, sorted, [&]
+	  {
+	    for (int i{0}; i < count * 10; ++i)
+	      { algorithm::select(opts.tourney_size, 0, opts.fit_size, pop); }
+	  });
+
+  // Offspring (per child) and a whole generation as in genetic().
+  measure("new-offspring", opts.pop_size, populate, [&]
+	  { algorithm::new_offspring(pop, 1, opts); });
+  measure("generation", 1, populate, [&]
+	  {
+	    Individual best = *min_element(begin(pop), end(pop),
+					   algorithm::compare_fitness());
+	    vector<Individual> offspring = algorithm::new_offspring(pop, 1, opts);
+	    random_generator::int_dist dist{0, opts.pop_size - 1};
+	    for (int e{0}; e < opts.elitism_size; ++e)
+	      { offspring[dist(rg.engine)] = best; }
+	    pop = move(offspring);
+	  });
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+/* budget.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for budget namespace
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include "budget.hpp"
+#include "../options/options.hpp"
+
+namespace budget
+{
+  // The calling thread's trial.
+  thread_local Account* active{nullptr};
+
+  // Bytes of nodes held by every trial, their peak, and the trials.
+  std::atomic<long> total{0};
+  std::atomic<long> peak_total{0};
+  std::atomic<int> accounts{0};
+
+  // The fraction of the memory limit at which limits start to tighten.
+  const double threshold{0.75};
+
+  const double megabyte{1048576.};
+
+  Limits
+  unlimited(const options::Options& opts)
+  { return Limits{opts.depth_limit, std::numeric_limits<int>::max()}; }
+
+  Account::Account(const options::Options& opts, std::size_t node_bytes)
+    : opts(opts), node_bytes{node_bytes}, nodes{0}, peak{0},
+      replacements{0}, current(unlimited(opts)), tightest(current),
+      tightened{-1}
+  {
+    ++accounts;
+    active = this;
+  }
+
+  Account::~Account()
+  {
+    total -= nodes * static_cast<long>(node_bytes);
+    --accounts;
+    active = nullptr;
+  }
+
+  /* Counts the trial's nodes now (its population, and while breeding,
+     its offspring too), then tightens or relaxes its limits by the
+     pressure on the memory limit. */
+  void
+  Account::update(long count, int generation)
+  {
+    const long used = total += (count - nodes) * static_cast<long>(node_bytes);
+    nodes = count;
+    peak = std::max(peak, nodes);
+    long seen = peak_total.load(std::memory_order_relaxed);
+    while (used > seen)
+      if (peak_total.compare_exchange_weak(seen, used))
+	{ break; }
+
+    if (opts.memory_limit <= 0)
+      { return; }
+    const double limit = opts.memory_limit * megabyte;
+    const double pressure =
+      std::min(std::max((used / limit - threshold) / (1 - threshold), 0.), 1.);
+    if (pressure == 0)
+      {
+	current = unlimited(opts);
+	return;
+      }
+
+    const double fair = limit / node_bytes / (2. * opts.pop_size * accounts);
+    current.depth = opts.depth_limit
+      - std::lround(pressure * (opts.depth_limit - opts.max_depth));
+    current.size = static_cast<int>(std::max(1., std::min(fair / pressure, 1e9)));
+
+    if (tightened < 0)
+      { tightened = generation; }
+    tightest.depth = std::min(tightest.depth, current.depth);
+    tightest.size = std::min(tightest.size, current.size);
+  }
+
+  Limits
+  Account::limits() const
+  { return current; }
+
+  // The trial's memory use and limits, for its log.
+  std::string
+  Account::report() const
+  {
+    std::ostringstream report;
+    report.precision(3);
+    report << "# Memory: peak of " << peak << " nodes ("
+	   << peak * node_bytes / megabyte << " MB) in the trial, "
+	   << peak_total.load() / megabyte << " MB in all trials";
+    if (opts.memory_limit > 0)
+      { report << " of " << opts.memory_limit << " MB"; }
+    report << "; " << replacements << " children over the limits replaced\n";
+    if (tightened >= 0)
+      {
+	report << "# Limits: tightened from generation " << tightened
+	       << ", to depth " << tightest.depth << " and size "
+	       << tightest.size << " at most\n";
+      }
+    return report.str();
+  }
+
+  Limits
+  limits(const options::Options& opts)
+  { return active ? active->limits() : unlimited(opts); }
+
+  void
+  replaced(long count)
+  {
+    if (active)
+      { active->replacements += count; }
+  }
+}
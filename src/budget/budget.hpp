@@ -0,0 +1,67 @@
+/* budget.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for budget namespace
+ * accounts for the nodes trials hold, tightening limits near --memory-limit
+ */
+
+#ifndef _BUDGET_H_
+#define _BUDGET_H_
+
+#include <cstddef>
+#include <string>
+
+// Forward declaration
+namespace options { struct Options; }
+
+namespace budget
+{
+  // The greatest depth and size (in nodes) a child may have.
+  struct Limits
+  {
+    int depth;
+    int size;
+  };
+
+  /* The nodes one trial's populations hold, active for its thread
+     while it lives, and counted toward the process's total.  Given a
+     memory limit, each update recomputes the trial's limits: past
+     three quarters of the limit, the depth limit falls toward the
+     initial maximum depth, and a size limit falls toward each
+     individual's fair share of the limit (of both generations, in
+     every trial). */
+  class Account
+  {
+    friend void replaced(long);
+
+  public:
+    Account(const options::Options&, std::size_t node_bytes);
+    ~Account();
+    Account(const Account&) = delete;
+    Account& operator=(const Account&) = delete;
+
+    void update(long nodes, int generation);
+    Limits limits() const;
+    std::string report() const;
+
+  private:
+    const options::Options& opts;
+    const std::size_t node_bytes;
+    long nodes; // Counted toward the total.
+    long peak;
+    long replacements;
+    Limits current;
+    Limits tightest;
+    int tightened; // The generation limits first tightened, or -1.
+  };
+
+  // The calling thread's trial's limits, else the options'.
+  Limits
+  limits(const options::Options&);
+
+  // Counts children replaced for exceeding the limits.
+  void
+  replaced(long count = 1);
+}
+
+#endif /* _BUDGET_H_ */
@@ -0,0 +1,76 @@
+/* convert.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Converts map files between the text and binary formats.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include "options/options.hpp"
+
+int
+main(int argc, char* argv[])
+{
+  using std::string;
+  using namespace boost::program_options;
+
+  string input, output;
+
+  options_description description{"Allowed options"};
+  description.add_options()
+    ("help,h", "produce help message")
+    ("input,i", value<string>(&input)->required(),
+     "set the map file to read (text or binary)")
+    ("output,o", value<string>(&output)->required(),
+     "set the map file to write")
+    ("text,t", "write the text format instead of the binary format");
+
+  positional_options_description positionals;
+  positionals.add("input", 1).add("output", 1);
+
+  variables_map variables_map;
+  try
+    {
+      store(command_line_parser(argc, argv).options(description)
+	    .positional(positionals).run(), variables_map);
+      if (variables_map.count("help"))
+	{
+	  std::cout << "Usage: antgp-convert <input> <output> [--text]\n\n"
+		    << description << std::endl;
+	  return EXIT_SUCCESS;
+	}
+      notify(variables_map);
+    }
+  catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  try
+    {
+      const auto tiles = options::Tiles::load(input);
+
+      std::ofstream file{output, std::ios_base::binary};
+      if (not file)
+	{ throw std::runtime_error{"File " + output + " could not be written!"}; }
+
+      if (variables_map.count("text"))
+	{ tiles->print(file); }
+      else
+	{ tiles->save(file); }
+    }
+  catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+/* dump.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Exports binary run logs as the text logs read by the tools/ scripts.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "logging/logging.hpp"
+
+// Writes the binary log as text, exactly as the text log would be.
+void
+dump(const std::string& input, std::ostream& output)
+{
+  std::ifstream file{input, std::ios_base::binary};
+  if (not file)
+    { throw std::runtime_error{"File " + input + " could not be read!"}; }
+  const std::string data{std::istreambuf_iterator<char>{file},
+      std::istreambuf_iterator<char>{}};
+
+  const auto log = logging::binary::view(input, data.data(), data.size());
+  output << log.header;
+  for (std::size_t r{0}; r < log.count; ++r)
+    { logging::log_info(output, log.records[r]); }
+  output << log.footer;
+}
+
+int
+main(int argc, char* argv[])
+{
+  using std::string;
+  using namespace boost::program_options;
+
+  std::vector<string> inputs;
+
+  options_description description{"Allowed options"};
+  description.add_options()
+    ("help,h", "produce help message")
+    ("input,i", value<std::vector<string>>(&inputs)->required(),
+     "set the binary logs to export, each to the same name with .dat")
+    ("stdout,c", "write to standard output instead");
+
+  positional_options_description positionals;
+  positionals.add("input", -1);
+
+  variables_map variables_map;
+  try
+    {
+      store(command_line_parser(argc, argv).options(description)
+	    .positional(positionals).run(), variables_map);
+      if (variables_map.count("help"))
+	{
+	  std::cout << "Usage: antgp-dump <log.bin>... [--stdout]\n\n"
+		    << description << std::endl;
+	  return EXIT_SUCCESS;
+	}
+      notify(variables_map);
+    }
+  catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  try
+    {
+      for (const auto& input : inputs)
+	{
+	  if (variables_map.count("stdout"))
+	    {
+	      dump(input, std::cout);
+	      continue;
+	    }
+
+	  const string extension{".bin"};
+	  const bool binary = input.size() > extension.size()
+	    and input.compare(input.size() - extension.size(),
+			      extension.size(), extension) == 0;
+	  const string output = (binary ? input.substr(0, input.size()
+						       - extension.size())
+				 : input) + ".dat";
+	  std::ofstream file{output};
+	  if (not file)
+	    { throw std::runtime_error{"File " + output + " could not be written!"}; }
+	  dump(input, file);
+	}
+    }
+  catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
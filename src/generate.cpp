@@ -0,0 +1,64 @@
+/* generate.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Writes a generated Santa Fe style trail in the map file format.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include "generator/generator.hpp"
+
+int
+main(int argc, char* argv[])
+{
+  using namespace boost::program_options;
+
+  generator::Parameters parameters;
+  std::string output;
+
+  options_description description{"Allowed options"};
+  description.add_options()
+    ("help,h", "produce help message")
+    ("output,o", value<std::string>(&output),
+     "set the map file to write (defaults to standard output)");
+  description.add(generator::description(parameters));
+
+  variables_map variables_map;
+  try
+    {
+      store(parse_command_line(argc, argv, description), variables_map);
+      notify(variables_map);
+    }
+  catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  if (variables_map.count("help"))
+    {
+      std::cout << description << std::endl;
+      return EXIT_SUCCESS;
+    }
+
+  const generator::grid_t rows = generator::trail(parameters);
+  if (output.empty())
+    { generator::write(std::cout, rows); }
+  else
+    {
+      std::ofstream file{output};
+      if (not file)
+	{
+	  std::cerr << "File " << output << " could not be written!\n";
+	  return EXIT_FAILURE;
+	}
+      generator::write(file, rows);
+    }
+
+  return EXIT_SUCCESS;
+}
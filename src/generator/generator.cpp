@@ -0,0 +1,194 @@
+/* generator.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for generator namespace
+ */
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+
+#include <boost/program_options.hpp>
+
+#include "generator.hpp"
+
+namespace generator
+{
+  // Defaults match the Santa Fe trail: 89 pieces of food on 32 by 32.
+  Parameters::Parameters(): width{32}, height{32}, density{0.087},
+			    gap_chance{0.15}, turn_chance{0.1}, seed{0} {}
+
+  /* Walk a random trail starting next to the ant (which starts in the
+     corner facing east), laying food on each step unless leaving a
+     gap.  Gaps are at most three cells long, as on the Santa Fe
+     trail.  The walk turns left or right at random, and prefers
+     cells not adjacent to the trail so far, crossing it straight
+     only when boxed in.  It stops once enough food is laid for the density, or
+     after a bounded number of steps on a crowded map. */
+  grid_t
+  trail(const Parameters& p)
+  {
+    assert(p.width > 0 and p.height > 0);
+    assert(p.density >= 0 and p.density <= 1);
+
+    grid_t rows(p.height, std::vector<bool>(p.width));
+    std::vector<std::vector<bool>> walked(p.height, std::vector<bool>(p.width));
+
+    std::mt19937_64 engine{p.seed};
+    std::bernoulli_distribution gap_dist{p.gap_chance};
+    std::bernoulli_distribution turn_dist{p.turn_chance};
+    std::bernoulli_distribution side_dist{0.5};
+
+    // Direction deltas in clockwise order: east, south, west, north.
+    const std::array<int, 4> dx{{1, 0, -1, 0}};
+    const std::array<int, 4> dy{{0, 1, 0, -1}};
+    const long width = p.width, height = p.height;
+    auto wrap = [](long i, long n) { return ((i % n) + n) % n; };
+
+    // True if the cell ahead in direction d, and those beside it, are off the trail.
+    auto open = [&](long x, long y, int d)
+      {
+	const long ax = wrap(x + dx[d], width), ay = wrap(y + dy[d], height);
+	const int side = (d + 1) % 4;
+	return not walked[ay][ax]
+	  and not walked[wrap(ay + dy[side], height)][wrap(ax + dx[side], width)]
+	  and not walked[wrap(ay - dy[side], height)][wrap(ax - dx[side], width)];
+      };
+
+    const std::size_t target = p.density * p.width * p.height;
+    const std::size_t limit = 4 * p.width * p.height;
+    std::size_t pieces{0};
+    int gap{0};
+    long x{0}, y{0};
+    int d{0};
+    walked[0][0] = true;
+
+    for (std::size_t step{0}; pieces < target and step < limit; ++step)
+      {
+	// Turn randomly or when blocked, else go straight (crossing if boxed in).
+	const int turn = side_dist(engine) ? 1 : 3;
+	std::array<int, 3> choices{{d, (d + turn) % 4, (d + 4 - turn) % 4}};
+	if (turn_dist(engine))
+	  { std::rotate(begin(choices), std::next(begin(choices)), end(choices)); }
+	const auto choice = std::find_if(begin(choices), end(choices), [&](int c)
+					 { return open(x, y, c); });
+	if (choice != end(choices))
+	  { d = *choice; }
+
+	x = wrap(x + dx[d], width);
+	y = wrap(y + dy[d], height);
+	walked[y][x] = true;
+
+	if (gap < 3 and gap_dist(engine))
+	  { ++gap; }
+	else
+	  {
+	    gap = 0;
+	    if (not rows[y][x])
+	      {
+		rows[y][x] = true;
+		++pieces;
+	      }
+	  }
+      }
+    return rows;
+  }
+
+  options::Map
+  map(const Parameters& p, int ticks)
+  {
+    return options::Map{std::make_shared<const options::Tiles>(trail(p), source(p)),
+	ticks};
+  }
+
+  void
+  write(std::ostream& out, const grid_t& rows)
+  {
+    std::string line;
+    for (const auto& row : rows)
+      {
+	line.clear();
+	for (bool food : row)
+	  { line += food ? 'x' : '.'; }
+	out << line << '\n';
+      }
+  }
+
+  std::string
+  source(const Parameters& p)
+  {
+    std::ostringstream out;
+    out.precision(std::numeric_limits<float>::max_digits10);
+    out << "generated width " << p.width << " height " << p.height
+	<< " density " << p.density << " gap-chance " << p.gap_chance
+	<< " turn-chance " << p.turn_chance << " seed " << p.seed;
+    return out.str();
+  }
+
+  bool
+  parse(const std::string& source, Parameters& p)
+  {
+    std::istringstream in{source};
+    std::string name;
+    Parameters parsed;
+    if (not (in >> name) or name != "generated")
+      { return false; }
+    while (in >> name)
+      {
+	if (name == "width")
+	  { in >> parsed.width; }
+	else if (name == "height")
+	  { in >> parsed.height; }
+	else if (name == "density")
+	  { in >> parsed.density; }
+	else if (name == "gap-chance")
+	  { in >> parsed.gap_chance; }
+	else if (name == "turn-chance")
+	  { in >> parsed.turn_chance; }
+	else if (name == "seed")
+	  { in >> parsed.seed; }
+	else
+	  { return false; }
+      }
+    if (in.fail() and not in.eof())
+      { return false; }
+    p = parsed;
+    return true;
+  }
+
+  boost::program_options::options_description
+  description(Parameters& p)
+  {
+    using namespace boost::program_options;
+    options_description description{"Trail generation options"};
+    description.add_options()
+      ("trail-width", value<std::size_t>(&p.width)->
+       default_value(p.width),
+       "set the width of generated trails")
+
+      ("trail-height", value<std::size_t>(&p.height)->
+       default_value(p.height),
+       "set the height of generated trails")
+
+      ("trail-density", value<float>(&p.density)->
+       default_value(p.density),
+       "set the fraction of cells of generated trails that are food")
+
+      ("trail-gap-chance", value<float>(&p.gap_chance)->
+       default_value(p.gap_chance),
+       "set the probability that a trail step leaves a gap")
+
+      ("trail-turn-chance", value<float>(&p.turn_chance)->
+       default_value(p.turn_chance),
+       "set the probability that a trail step turns")
+
+      ("trail-seed", value<unsigned long>(&p.seed)->
+       default_value(p.seed),
+       "set the seed of generated trails");
+    return description;
+  }
+}
@@ -0,0 +1,64 @@
+/* generator.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for generator namespace
+ * procedurally generates Santa Fe style trails
+ */
+
+#ifndef _GENERATOR_H_
+#define _GENERATOR_H_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options/options_description.hpp>
+
+#include "../options/options.hpp"
+
+namespace generator
+{
+  // Parameters of a generated trail.
+  struct Parameters
+  {
+    std::size_t width;
+    std::size_t height;
+    float density;
+    float gap_chance;
+    float turn_chance;
+    unsigned long seed;
+    Parameters();
+  };
+
+  // A grid of bits, true where there is food (packed, as trails can be large).
+  typedef std::vector<std::vector<bool>> grid_t;
+
+  // Returns a trail grid deterministically generated from parameters.
+  grid_t
+  trail(const Parameters&);
+
+  // Returns the generated trail as a map with the given ticks.
+  options::Map
+  map(const Parameters&, int);
+
+  // Writes a trail grid in the '.' and 'x' map file format.
+  void
+  write(std::ostream&, const grid_t&);
+
+  /* Returns the source of a generated trail's map, naming its
+     parameters (exactly) for its traces. */
+  std::string
+  source(const Parameters&);
+
+  /* Sets the parameters named by a generated trail's source, returning
+     false if it is not one. */
+  bool
+  parse(const std::string&, Parameters&);
+
+  // Returns CLI options which set the given parameters.
+  boost::program_options::options_description
+  description(Parameters&);
+}
+
+#endif /* _GENERATOR_H_ */
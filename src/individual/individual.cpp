@@ -13,7 +13,10 @@
 #include <vector>
 
 #include "individual.hpp"
+#include "primitives.hpp"
 #include "../options/options.hpp"
+#include "../problem/ant.hpp"
+#include "../problem/regression.hpp"
 #include "../random_generator/random_generator.hpp"
 
 namespace individual
@@ -25,65 +28,42 @@ namespace individual
   // Default Size struct constructor.
   Size::Size(): internals{0}, leaves{0}, depth{0} {}
 
-  using F = Function;
-  // Vectors of same-arity function enums.
-  vector<F> nullaries { F::left, F::right, F::forward };
-  vector<F> binaries { F::prog2, F::iffoodahead };
-  vector<F> trinaries { F::prog3 };
-
-  /* Vectors of available function enums.  Should be moved into
-     Options struct. */
-  vector<F> leaves = nullaries;
-  vector<F> internals { F::prog2, F::prog3, F::iffoodahead };
-
-  // Returns a random function from a given set of functions.
-  Function
-  get_function(const vector<Function>& functions)
-  {
-    size_dist dist{0, functions.size() - 1}; // closed interval
-    return functions[dist(rg.engine)];
-  }
-
-  // Returns bool of whether or not the item is in the set.
-  template<typename I, typename S> bool
-  contains(const I& item, const S& set)
-  { return find(begin(set), end(set), item) != end(set); }
-
-  // Returns the appropriate arity for a given function.
-  int
-  get_arity(const Function function)
+  // Returns a random function from a given compile-time set of functions.
+  template<typename Set> typename Set::value_type
+  get_function()
   {
-    if (contains(function, nullaries))
-      { return 0; }
-    else if (contains(function, binaries))
-      { return 2; }
-    else if (contains(function, trinaries))
-      { return 3; }
-    assert(false);
+    size_dist dist{0, Set::size - 1}; // closed interval
+    return Set::values[dist(rg.engine)];
   }
 
   // Default constructor for "empty" node
-  Node::Node(): function{Function::nil}, arity{0} {}
+  template<typename Problem>
+  Node<Problem>::Node(): function{Function::nil}, arity{0}, id{-1} {}
 
   // Delegate that unpacks a tuple as args to actual constructor
-  Node::Node(std::tuple<Method, int, int> args):
+  template<typename Problem>
+  Node<Problem>::Node(std::tuple<Method, int, int> args):
     Node{std::get<0>(args), std::get<1>(args), std::get<2>(args)} {}
 
   /* Recursively constructs a parse tree using the given method
      (either 'grow' or 'full'). */
-  Node::Node(Method method, int max_depth, int depth): Node{}
+  template<typename Problem>
+  Node<Problem>::Node(Method method, int max_depth, int depth): Node{}
   {
+    typedef typename Problem::Primitives::leaves leaves;
+    typedef typename Problem::Primitives::internals internals;
+
     // Create leaf node if at the max depth or randomly (if growing).
     float chance =
-      static_cast<float>(leaves.size()) / (leaves.size() + internals.size());
+      static_cast<float>(leaves::size) / (leaves::size + internals::size);
     bool_dist dist(chance);
     if (depth == max_depth
 	or (depth != 0 and (method == Method::grow and dist(rg.engine))))
-      { function = get_function(leaves); }
+      { function = get_function<leaves>(); }
     else // Otherwise choose an internal node.
       {
-	function = get_function(internals);
-	arity = get_arity(function);
+	function = get_function<internals>();
+	arity = Problem::Primitives::arity(function);
 	// Recursively create subtrees.
 	children.reserve(arity);
 	generate_n(back_inserter(children), arity, [method, max_depth, depth]
@@ -111,39 +91,17 @@ namespace individual
   }
 
   // Returns a string visually representing a particular node.
-  string
-  Node::represent() const
+  template<typename Problem> string
+  Node<Problem>::represent() const
   {
-    switch (function)
-      {
-      case F::nil:
-	{ assert(false); } // Never represent empty node.
-
-      case F::prog2:
-	{ return "prog-2"; }
-
-      case F::prog3:
-	{ return "prog-3"; }
-
-      case F::iffoodahead:
-	{ return "if-food-ahead"; }
-
-      case F::left:
-	{ return "left"; }
-
-      case F::right:
-	{ return "right"; }
-
-      case F::forward:
-	{ return "forward"; }
-      }
-    assert(false); // Every node should have been matched.
+    assert(function != Function::nil); // Never represent empty node.
+    return Problem::Primitives::name(function);
   }
 
   /* Returns string representation of expression in Polish/prefix
      notation using a pre-order traversal. */
-  string
-  Node::print() const
+  template<typename Problem> string
+  Node<Problem>::print() const
   {
     if (children.empty())
       { return represent(); }
@@ -156,48 +114,9 @@ namespace individual
     return formula + ")";
   }
 
-  /* Evaluates an ant over a given map using a depth-first post-order
-     recursive continuous evaluation of a decision tree. */
-  void
-  Node::evaluate(options::Map& map) const
-  {
-    if (not map.active()) return;
-
-    switch (function)
-      {
-      case F::left:
-	{ map.left(); break; } // Terminal case
-
-      case F::right:
-	{ map.right(); break; } // Terminal case
-
-      case F::forward:
-	{ map.forward(); break; } // Terminal case
-
-      case F::iffoodahead:
-	{
-	  if (map.look()) // Do left or right depending on if food ahead
-	    { begin(children)->evaluate(map); }
-	  else
-	    { next(begin(children))->evaluate(map); }
-	  break;
-	}
-
-      case F::prog2: // Falls through
-      case F::prog3:
-	{
-	  for (const auto& child : children)
-	    { child.evaluate(map); }
-	  break;
-	}
-
-      case F::nil:
-	{ assert(false); } // Never evaluate empty node
-      }
-  }
-
   /* Get size of node. */
-  const Size Node::size() const
+  template<typename Problem> const Size
+  Node<Problem>::size() const
   {
     Size s;
     size(s);
@@ -207,8 +126,8 @@ namespace individual
   /* Recursively count children and find maximum depth of tree via
      depth-first traversal.  Keep track of internals, leaves, and depth
      via Size struct sent by reference. */
-  void
-  Node::size(Size& s) const
+  template<typename Problem> void
+  Node<Problem>::size(Size& s) const
   {
     if (children.empty())
       {
@@ -217,26 +136,40 @@ namespace individual
       }
     else
       {
-	vector<int> depths;
-	depths.reserve(arity);
+	unsigned int depth{0};
 	for (const auto& child : children)
 	  {
 	    child.size(s); // Recursively call size()
-	    depths.push_back(s.depth); // Save depths
+	    depth = std::max(depth, s.depth); // Keep the max depth
 	  }
 
 	++s.internals; // Count as internal node
-	s.depth = 1 + *max_element(begin(depths), end(depths)); // Save max depth
+	s.depth = 1 + depth; // Save max depth
       }
   }
 
+  /* Recursively count the nodes of each function, indexed by
+     Function. */
+  template<typename Problem> void
+  Node<Problem>::count(std::vector<int>& counts) const
+  {
+    ++counts[static_cast<int>(function)];
+    for (const auto& child : children)
+      { child.count(counts); }
+  }
+
   // Used to represent "not-found" (similar to a NULL pointer).
-  Node empty;
+  template<typename Problem> Node<Problem>&
+  empty()
+  {
+    static Node<Problem> node;
+    return node;
+  }
 
   /* Depth-first search for taget node.  Must be seeking either
      internal or leaf, cannot be both. */
-  Node&
-  Node::visit(const Size& i, Size& visiting)
+  template<typename Problem> Node<Problem>&
+  Node<Problem>::visit(const Size& i, Size& visiting)
   {
     for (auto& child : children)
       {
@@ -254,27 +187,27 @@ namespace individual
 	if (temp.function != Function::nil)
 	  { return temp; }
       }
-    return empty;
+    return empty<Problem>();
   }
 
-  void
-  Node::mutate(int min, int max, float chance)
+  template<typename Problem> void
+  Node<Problem>::mutate(int min, int max, float chance)
   {
+    typedef typename Problem::Primitives::leaves leaves;
+    typedef typename Problem::Primitives::internals internals;
+
+    const Function old = function;
     if (arity == 0)
       {
-	const Function old = function;
 	while (function == old)
-	  function = get_function(leaves);
+	  function = get_function<leaves>();
       }
-    else if (arity == 2 or arity == 3)
+    else
       {
-	const Function old = function;
 	while (function == old)
-	  function = get_function(internals);
-	arity = get_arity(function);
+	  function = get_function<internals>();
+	arity = Problem::Primitives::arity(function);
       }
-    else
-      { assert(false); }
 
     // Fix arity mismatches caused by mutation
     while (children.size() > arity)
@@ -288,19 +221,22 @@ namespace individual
   }
 
   // Default constructor for Individual
-  Individual::Individual() {}
+  template<typename Problem>
+  Individual<Problem>::Individual(): score{0}, fitness{0}, adjusted{0} {}
 
   /* Create an Individual tree by having a root node (to which the
-     actual construction is delegated).  Calling evaluate updates the
-     size, fitness, adjusted fitness, and score. */
-  Individual::Individual(const options::Options& options)
+     actual construction is delegated).  The size is kept current from
+     here (by the genetic operators), and calling evaluate updates the
+     fitness, adjusted fitness, and score. */
+  template<typename Problem>
+  Individual<Problem>::Individual(const options::Options& options)
     : root{get_node_args(options.min_depth, options.max_depth, options.grow_chance)},
-      score{0}, fitness{0}, adjusted{0}
-  { evaluate(options.map); }
+      size(root.size()), score{0}, fitness{0}, adjusted{0}
+  { evaluate(Problem::cases(options), options); }
 
   // Return string representation of a tree's size and fitness.
-  string
-  Individual::print() const
+  template<typename Problem> string
+  Individual<Problem>::print() const
   {
     using std::to_string;
 
@@ -315,45 +251,21 @@ namespace individual
   }
 
   // Return string represenation of tree's expression (delegated).
-  string
-  Individual::print_formula() const
+  template<typename Problem> string
+  Individual<Problem>::print_formula() const
   { return "# Formula: " + root.print() + "\n"; }
 
-  /* Evaluate Individual for given values and calculate size.  Update
-     Individual's size and fitness accordingly. Return non-empty
-     string if printing. */
-  string
-  Individual::evaluate(options::Map map, float penalty, bool print)
-  {
-    // Update size on evaluation because it's incredibly convenient.
-    size = root.size();
-
-    // Run ant across map and retrieve fitness.
-    while (map.active())
-      { root.evaluate(map); }
-    score = map.fitness();
-
-    // Adjusted fitness does not have size penalty.
-    adjusted = static_cast<float>(score) / map.max();
-
-    // Apply size penalty.
-    fitness = score - penalty * get_total();
-
-    string evaluation;
-    if (print)
-      { evaluation = map.print(); }
-
-    return evaluation;
-  }
-
   using O = Operator;
   // Vectors of same-arity function enums.
   vector<O> operators {O::shrink, O::hoist, O::subtree, O::replacement};
 
-
-  // Mutate each node with given probability.
-  void
-  Individual::mutate(int min, int max, float chance)
+  /* Mutate each node with given probability.  The problem is told of
+     the node about to change (modified), and of its replacement along
+     with the number of the node it replaced (replaced).  The size is
+     then current (as after crossover), so limits apply before
+     evaluation. */
+  template<typename Problem> void
+  Individual<Problem>::mutate(int min, int max, float chance)
   {
     size_dist op_dist{0, operators.size() - 1}; // closed interval
     const Operator op = operators[op_dist(rg.engine)];
@@ -365,29 +277,48 @@ namespace individual
     const unsigned int c = c_dist(rg.engine);
     assert(c <= at(p).arity);
 
+    Node<Problem>& child = at(p).children[c];
+    const int id = child.id;
     switch (op)
       {
       case O::shrink:
 	// Replace c with a leaf node
-	at(p).children[c] = std::move(Node{get_node_args(0, 0)}); break;
+	modified(child);
+	child = std::move(Node<Problem>{get_node_args(0, 0)});
+	replaced(child, id);
+	break;
 
       case O::hoist:
-	// Make c the new root
-	std::swap(root, at(p).children[c]); break;
+	{
+	  // Make c the new root (moved out first, as root owns it)
+	  modified(root);
+	  const int root_id = root.id;
+	  Node<Problem> hoisted = std::move(child);
+	  root = std::move(hoisted);
+	  replaced(root, root_id);
+	  break;
+	}
 
       case O::subtree:
 	// Replace c with new subtree to depth 6
-	at(p).children[c] = std::move(Node{get_node_args(min, max, chance)}); break;
+	modified(child);
+	child = std::move(Node<Problem>{get_node_args(min, max, chance)});
+	replaced(child, id);
+	break;
 
       case O::replacement:
 	// Replace c with node of same type (internal/leaf)
-	at(p).children[c].mutate(min, max, chance); break;
+	modified(child);
+	child.mutate(min, max, chance);
+	replaced(child, id);
+	break;
       }
+    size = root.size();
   }
 
   // Safely return reference to desired node.
-  Node&
-  Individual::operator[](const Size& i)
+  template<typename Problem> Node<Problem>&
+  Individual<Problem>::operator[](const Size& i)
   {
     assert(i.internals <= static_cast<unsigned int>(get_internals()));
     assert(i.leaves <= static_cast<unsigned int>(get_leaves()));
@@ -400,12 +331,12 @@ namespace individual
       return root.visit(i, visiting);
   }
 
-  Node&
-  Individual::at(const Size& i)
+  template<typename Problem> Node<Problem>&
+  Individual<Problem>::at(const Size& i)
   { return operator[](i); }
 
-  Size
-  Individual::get_node_location(Type type) const
+  template<typename Problem> Size
+  Individual<Problem>::get_node_location(Type type) const
   {
     Size target;
     // Guaranteed to have at least 1 leaf, but may have 0 internals.
@@ -426,47 +357,76 @@ namespace individual
 
   /* Swap two random subtrees between Individuals "a" and "b",
      selecting an internal node with chance probability. */
-  void
-  crossover(const float chance, Individual& a, Individual& b)
+  template<typename Problem> void
+  crossover(const float chance, Individual<Problem>& a, Individual<Problem>& b)
   {
+    typedef typename Individual<Problem>::Type Type;
     bool_dist dist(chance);
 
-    Individual::Type type_a = (dist(rg.engine))
-      ? Individual::Type::internal : Individual::Type::leaf;
+    Type type_a = (dist(rg.engine)) ? Type::internal : Type::leaf;
 
-    Individual::Type type_b = (dist(rg.engine))
-      ? Individual::Type::internal : Individual::Type::leaf;
+    Type type_b = (dist(rg.engine)) ? Type::internal : Type::leaf;
 
-    std::swap(a[a.get_node_location(type_a)], b[b.get_node_location(type_b)]);
+    Node<Problem>& node_a = a[a.get_node_location(type_a)];
+    Node<Problem>& node_b = b[b.get_node_location(type_b)];
+    a.modified(node_a);
+    b.modified(node_b);
+    const int id_a = node_a.id, id_b = node_b.id;
+    std::swap(node_a, node_b);
+    a.replaced(node_a, id_a);
+    b.replaced(node_b, id_b);
+    a.size = a.root.size();
+    b.size = b.root.size();
   }
 
   // Read-only "getters" for private data
 
-  int
-  Individual::get_internals() const
+  template<typename Problem> int
+  Individual<Problem>::get_internals() const
   { return size.internals; }
 
-  int
-  Individual::get_leaves() const
+  template<typename Problem> int
+  Individual<Problem>::get_leaves() const
   { return size.leaves; }
 
-  int
-  Individual::get_total() const
+  template<typename Problem> int
+  Individual<Problem>::get_total() const
   { return size.internals + size.leaves; }
 
-  int
-  Individual::get_depth() const
+  template<typename Problem> int
+  Individual<Problem>::get_depth() const
   { return size.depth; }
 
-  int
-  Individual::get_score() const
+  template<typename Problem> int
+  Individual<Problem>::get_score() const
   { return score; }
 
-  float
-  Individual::get_fitness() const
+  template<typename Problem> float
+  Individual<Problem>::get_fitness() const
   { return fitness; }
 
-  float
-  Individual::get_adjusted() const
+  template<typename Problem> float
+  Individual<Problem>::get_adjusted() const
   { return adjusted; }
+
+  // Return the number of nodes of each function, indexed by Function.
+  template<typename Problem> std::vector<int>
+  Individual<Problem>::get_counts() const
+  {
+    std::vector<int> counts(Problem::Primitives::size, 0);
+    root.count(counts);
+    return counts;
+  }
+
+  /* The problems, whose evaluation (specialized in their own source
+     files) is all that differs. */
+  template class Node<problem::Ant>;
+  template class Individual<problem::Ant>;
+  template void crossover(float, Individual<problem::Ant>&,
+			  Individual<problem::Ant>&);
+
+  template class Node<problem::Regression>;
+  template class Individual<problem::Regression>;
+  template void crossover(float, Individual<problem::Regression>&,
+			  Individual<problem::Regression>&);
 }
@@ -8,10 +8,14 @@
 #ifndef _INDIVIDUAL_H_
 #define _INDIVIDUAL_H_
 
+#include <limits>
+#include <memory>
 #include <string>
+#include <tuple>
 #include <vector>
 
-namespace options { struct Options; class Map; }
+namespace options { struct Options; }
+namespace jit { class Compiler; }
 
 namespace individual
 {
@@ -27,15 +31,30 @@ namespace individual
   // Available methods for tree creation.
   enum class Method {grow, full};
 
-  // List of valid functions for an expression.
-  enum class Function {nil, prog2, prog3, iffoodahead, left, right, forward};
+  template<typename Problem> class Individual;
 
-  // Implements a recursive parse tree representing an expression.
+  template<typename Problem> void
+  crossover(float, Individual<Problem>&, Individual<Problem>&);
+
+  template<typename Problem, typename Problem::Function...> struct Registry;
+
+  /* Implements a recursive parse tree representing an expression of
+     a problem's primitives.  The Problem (see problem/ant.hpp)
+     defines its Function enum, the primitives' Registry, the Context
+     they act on and the Value they return, its training Cases, and
+     the State each individual keeps; it specializes evaluate (of
+     Node and Individual), plot, modified and replaced for itself. */
+  template<typename Problem>
   class Node
   {
-    friend class Individual;
+    friend class Individual<Problem>;
+    friend void crossover<>(float, Individual<Problem>&, Individual<Problem>&);
+    friend Problem;
+    template<typename P, typename P::Function...> friend struct Registry;
+    friend class jit::Compiler;
 
   public:
+    typedef typename Problem::Function Function;
     Node();
     Node(Method, int, int);
     Node(std::tuple<Method, int, int>);
@@ -43,24 +62,30 @@ namespace individual
   protected:
     std::string print() const;
     std::string represent() const;
-    void evaluate(options::Map&) const;
+    typename Problem::Value evaluate(typename Problem::Context&) const;
     const Size size() const;
     Node& visit(const Size&, Size&);
     void mutate(int, int, float);
     std::vector<Node> children;
     Function function;
     unsigned int arity;
+    int id; // Preorder number given by the problem's evaluation, or -1.
 
   private:
     void size(Size&) const;
+    void count(std::vector<int>&) const;
   };
 
   // Implemented genetic operators for Individuals
   enum class Operator {shrink, hoist, subtree, replacement};
 
+  template<typename Problem>
   class Individual
   {
+    friend Problem;
+
   public:
+    typedef typename Problem::Cases Cases;
     Individual();
     Individual(const options::Options&);
 
@@ -74,22 +99,28 @@ namespace individual
     int get_score() const;
     float get_fitness() const;
     float get_adjusted() const;
+    std::vector<int> get_counts() const;
 
-    Node& operator[](const Size&);
-    Node& at(const Size&);
+    Node<Problem>& operator[](const Size&);
+    Node<Problem>& at(const Size&);
     void mutate(int, int, float);
-    std::string evaluate(options::Map, float penalty = 0, bool print = false);
-    friend void crossover(float, Individual&, Individual&);
+    void evaluate(const Cases&, const options::Options&,
+		  float threshold = -std::numeric_limits<float>::infinity());
+    std::string plot(const options::Options&) const;
+    friend void crossover<>(float, Individual&, Individual&);
 
   private:
-    Node root;
+    Node<Problem> root;
     Size size;
     int score;
     float fitness;
     float adjusted;
+    typename Problem::State state;
 
     enum class Type {leaf, internal};
     Size get_node_location(Type) const;
+    void modified(const Node<Problem>&);
+    void replaced(Node<Problem>&, int);
   };
 }
 
@@ -0,0 +1,124 @@
+/* primitives.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Compile-time registry of the primitives (functions) of a problem's
+ * expressions
+ */
+
+#ifndef _PRIMITIVES_H_
+#define _PRIMITIVES_H_
+
+#include <cstddef>
+#include <type_traits>
+
+#include "individual.hpp"
+
+namespace individual
+{
+  /* Each problem defines every primitive's arity, name, whether it
+     evaluates just one of its children (a conditional) rather than
+     all in order, and its action on the problem's context once, as a
+     specialization of its Primitive member template, and registers
+     them in its Primitives (see problem/ant.hpp).  To add a primitive
+     (say prog-4), add it to the problem's Function enum, specialize
+     Primitive for it, and list it in the Registry; the arity, name,
+     conditional, and dispatch tables, and the leaf and internal sets,
+     follow. */
+
+  // A compile-time list of a problem's functions, also usable as an array.
+  template<typename Problem, typename Problem::Function... Fs>
+  struct List
+  {
+    typedef typename Problem::Function value_type;
+    static constexpr std::size_t size = sizeof...(Fs);
+    static constexpr value_type values[sizeof...(Fs)] = {Fs...};
+  };
+
+  template<typename Problem, typename Problem::Function... Fs>
+  constexpr typename Problem::Function List<Problem, Fs...>::values[sizeof...(Fs)];
+
+  // Filters the given functions into a List of leaves or internals.
+  template<typename Problem, bool Leaves, typename Out,
+	   typename Problem::Function... Fs>
+  struct Filter { typedef Out type; };
+
+  template<typename Problem, bool Leaves, typename Problem::Function... Out,
+	   typename Problem::Function F, typename Problem::Function... Fs>
+  struct Filter<Problem, Leaves, List<Problem, Out...>, F, Fs...>
+  {
+    typedef typename std::conditional<
+      (Problem::template Primitive<F>::arity == 0) == Leaves,
+      List<Problem, Out..., F>, List<Problem, Out...>>::type next;
+    typedef typename Filter<Problem, Leaves, next, Fs...>::type type;
+  };
+
+  // True if the functions are listed in enum order, following nil.
+  template<typename Problem, int I, typename Problem::Function... Fs>
+  struct Ordered : std::true_type {};
+
+  template<typename Problem, int I, typename Problem::Function F,
+	   typename Problem::Function... Fs>
+  struct Ordered<Problem, I, F, Fs...>
+    : std::integral_constant<bool, static_cast<int>(F) == I
+			     and Ordered<Problem, I + 1, Fs...>::value> {};
+
+  /* Tables of every registered primitive of a problem, indexed by
+     Function (where nil, at zero, has no name or action). */
+  template<typename Problem, typename Problem::Function... Fs>
+  struct Registry
+  {
+    static_assert(Ordered<Problem, 1, Fs...>::value,
+		  "primitives must be registered in Function enum order");
+
+    typedef typename Problem::Function Function;
+    static constexpr std::size_t size = sizeof...(Fs) + 1; // With nil.
+    typedef typename Problem::Value (*action_t)(const Node<Problem>&,
+						typename Problem::Context&);
+
+    static constexpr unsigned int arities[] =
+      {0, Problem::template Primitive<Fs>::arity...};
+    static constexpr const char* names[] =
+      {"nil", Problem::template Primitive<Fs>::name...};
+    static constexpr bool conditionals[] =
+      {false, Problem::template Primitive<Fs>::conditional...};
+    static constexpr action_t actions[] =
+      {nullptr, &Problem::template Primitive<Fs>::evaluate...};
+
+    typedef typename Filter<Problem, true, List<Problem>, Fs...>::type leaves;
+    typedef typename Filter<Problem, false, List<Problem>, Fs...>::type internals;
+
+    static constexpr unsigned int
+    arity(Function f)
+    { return arities[static_cast<int>(f)]; }
+
+    static constexpr const char*
+    name(Function f)
+    { return names[static_cast<int>(f)]; }
+
+    static constexpr bool
+    conditional(Function f)
+    { return conditionals[static_cast<int>(f)]; }
+
+    static typename Problem::Value
+    evaluate(const Node<Problem>& node, typename Problem::Context& context)
+    { return actions[static_cast<int>(node.function)](node, context); }
+  };
+
+  template<typename Problem, typename Problem::Function... Fs>
+  constexpr std::size_t Registry<Problem, Fs...>::size;
+
+  template<typename Problem, typename Problem::Function... Fs>
+  constexpr unsigned int Registry<Problem, Fs...>::arities[];
+
+  template<typename Problem, typename Problem::Function... Fs>
+  constexpr const char* Registry<Problem, Fs...>::names[];
+
+  template<typename Problem, typename Problem::Function... Fs>
+  constexpr bool Registry<Problem, Fs...>::conditionals[];
+
+  template<typename Problem, typename Problem::Function... Fs>
+  constexpr typename Registry<Problem, Fs...>::action_t
+  Registry<Problem, Fs...>::actions[];
+}
+
+#endif /* _PRIMITIVES_H_ */
@@ -0,0 +1,224 @@
+/* jit.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for jit namespace
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "jit.hpp"
+#include "../individual/individual.hpp"
+#include "../options/options.hpp"
+#include "../problem/ant.hpp"
+
+namespace jit
+{
+  typedef problem::Ant::Function Function;
+  using options::Direction;
+
+#if defined(__x86_64__) && defined(__linux__)
+  bool
+  supported()
+  { return true; }
+#else
+  bool
+  supported()
+  { return false; }
+#endif
+
+  Program::Program(void* c, std::size_t s): code{c}, size{s} {}
+
+  Program::~Program()
+  { munmap(code, size); }
+
+  // Runs the compiled program (a System V function of the map).
+  void
+  Program::run(options::Map& map) const
+  { reinterpret_cast<void (*)(options::Map*)>(code)(&map); }
+
+  // Out of line map accesses called by compiled programs.
+  void
+  forward(options::Map* map)
+  { map->forward(); }
+
+  bool
+  look(const options::Map* map)
+  { return map->look(); }
+
+  /* The new direction after turning left or right, packed one byte
+     per current direction into an immediate. */
+  static_assert(static_cast<int>(Direction::north) == 0
+		and static_cast<int>(Direction::south) == 1
+		and static_cast<int>(Direction::east) == 2
+		and static_cast<int>(Direction::west) == 3,
+		"turn tables assume the Direction enum order");
+  const std::uint32_t left_turns = 3 | 2 << 8 | 0 << 16 | 1 << 24;
+  const std::uint32_t right_turns = 2 | 3 << 8 | 1 << 16 | 0 << 24;
+
+  /* Emits x86-64 for a tree with the map pointer kept in rbx.  Every
+     node first checks the ticks (as Node::evaluate does), jumping to
+     the shared exit when out; turns are inlined table lookups on the
+     direction; prog nodes are straight-line code; if-food-ahead is a
+     branch on look; and forward and look call out to the map.  Trees
+     with other primitives fail to compile, and are interpreted. */
+  class Compiler
+  {
+  public:
+    Compiler(): layout{options::Map::layout()} {}
+
+    std::shared_ptr<const Program>
+    compile(const individual::Node<problem::Ant>& root)
+    {
+      bytes({0x53});                   // push rbx
+      bytes({0x48, 0x89, 0xFB});       // mov rbx, rdi
+      const std::size_t loop = code.size();
+      node(root);
+      if (failed)
+	{ return nullptr; }
+      jump({0xE9}, loop);              // jmp loop
+      const std::size_t exit = code.size();
+      bytes({0x5B, 0xC3});             // pop rbx; ret
+      for (std::size_t at : exits)
+	{ patch(at, exit); }
+
+      // Copy into pages which are then made executable (not writable).
+      const std::size_t size = code.size();
+      void* pages = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (pages == MAP_FAILED)
+	{ return nullptr; }
+      std::memcpy(pages, code.data(), size);
+      if (mprotect(pages, size, PROT_READ | PROT_EXEC) != 0)
+	{
+	  munmap(pages, size);
+	  return nullptr;
+	}
+      return std::shared_ptr<const Program>{new Program{pages, size}};
+    }
+
+  private:
+    const options::Map::Layout layout;
+    std::vector<std::uint8_t> code;
+    std::vector<std::size_t> exits;
+    bool failed{false};
+
+    void
+    bytes(std::initializer_list<std::uint8_t> b)
+    { code.insert(end(code), b); }
+
+    void
+    value(std::uint64_t v, int n)
+    {
+      for (int i{0}; i < n; ++i, v >>= 8)
+	{ code.push_back(v & 0xFF); }
+    }
+
+    // Emits a 32 bit displacement from rbx.
+    void
+    field(std::ptrdiff_t offset)
+    { value(static_cast<std::uint32_t>(offset), 4); }
+
+    // Emits a jump opcode with a rel32 to target, returning its offset.
+    std::size_t
+    jump(std::initializer_list<std::uint8_t> opcode, std::size_t target = 0)
+    {
+      bytes(opcode);
+      const std::size_t at = code.size();
+      value(0, 4);
+      patch(at, target);
+      return at;
+    }
+
+    void
+    patch(std::size_t at, std::size_t target)
+    {
+      const std::int32_t rel = target - (at + 4);
+      std::memcpy(&code[at], &rel, 4);
+    }
+
+    // Calls a function of the map (in rdi), result in al.
+    void
+    call(const void* function)
+    {
+      bytes({0x48, 0x89, 0xDF});       // mov rdi, rbx
+      bytes({0x48, 0xB8});             // mov rax, imm64
+      value(reinterpret_cast<std::uintptr_t>(function), 8);
+      bytes({0xFF, 0xD0});             // call rax
+    }
+
+    void
+    turn(std::uint32_t turns)
+    {
+      bytes({0x8B, 0x8B});             // mov ecx, [rbx + direction]
+      field(layout.direction);
+      bytes({0xC1, 0xE1, 0x03});       // shl ecx, 3
+      bytes({0xB8});                   // mov eax, turns
+      value(turns, 4);
+      bytes({0xD3, 0xE8});             // shr eax, cl
+      bytes({0x0F, 0xB6, 0xC0});       // movzx eax, al
+      bytes({0x89, 0x83});             // mov [rbx + direction], eax
+      field(layout.direction);
+      bytes({0x83, 0x83});             // add dword [rbx + ticks], 1
+      field(layout.ticks);
+      bytes({0x01});
+    }
+
+    void
+    node(const individual::Node<problem::Ant>& n)
+    {
+      bytes({0x8B, 0x83});             // mov eax, [rbx + ticks]
+      field(layout.ticks);
+      bytes({0x3B, 0x83});             // cmp eax, [rbx + max_ticks]
+      field(layout.max_ticks);
+      exits.push_back(jump({0x0F, 0x8D})); // jge exit
+
+      switch (n.function)
+	{
+	case Function::left:
+	  { turn(left_turns); break; }
+
+	case Function::right:
+	  { turn(right_turns); break; }
+
+	case Function::forward:
+	  { call(reinterpret_cast<const void*>(&forward)); break; }
+
+	case Function::iffoodahead:
+	  {
+	    call(reinterpret_cast<const void*>(&look));
+	    bytes({0x84, 0xC0});       // test al, al
+	    const std::size_t otherwise = jump({0x0F, 0x84}); // jz otherwise
+	    node(n.children[0]);
+	    const std::size_t done = jump({0xE9}); // jmp done
+	    patch(otherwise, code.size());
+	    node(n.children[1]);
+	    patch(done, code.size());
+	    break;
+	  }
+
+	case Function::prog2: // Falls through
+	case Function::prog3:
+	  {
+	    for (const auto& child : n.children)
+	      { node(child); }
+	    break;
+	  }
+
+	default: // Primitives without native code are interpreted.
+	  { failed = true; }
+	}
+    }
+  };
+
+  std::shared_ptr<const Program>
+  compile(const individual::Node<problem::Ant>& root)
+  {
+    if (not supported())
+      { return nullptr; }
+    return Compiler{}.compile(root);
+  }
+}
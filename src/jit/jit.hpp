@@ -0,0 +1,47 @@
+/* jit.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for jit namespace
+ * compiles ant programs to native x86-64 code
+ */
+
+#ifndef _JIT_H_
+#define _JIT_H_
+
+#include <cstddef>
+#include <memory>
+
+namespace options { class Map; }
+namespace individual { template<typename Problem> class Node; }
+namespace problem { struct Ant; }
+
+namespace jit
+{
+  // True if programs can be compiled on this platform.
+  bool
+  supported();
+
+  // A compiled program in its own executable pages.
+  class Program
+  {
+  public:
+    ~Program();
+    Program(const Program&) = delete;
+    Program& operator=(const Program&) = delete;
+    void run(options::Map&) const;
+
+  private:
+    friend class Compiler;
+    Program(void*, std::size_t);
+    void* code;
+    std::size_t size;
+  };
+
+  /* Compiles an ant program which repeatedly evaluates the given tree
+     until the map is out of ticks, exactly as the interpreter does.
+     Returns null if unsupported. */
+  std::shared_ptr<const Program>
+  compile(const individual::Node<problem::Ant>&);
+}
+
+#endif /* _JIT_H_ */
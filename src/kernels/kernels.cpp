@@ -0,0 +1,203 @@
+/* kernels.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for kernels namespace
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+
+#ifdef HAVE_IMMINTRIN_H
+#include <immintrin.h>
+#endif
+
+#include "kernels.hpp"
+
+namespace kernels
+{
+  Errors::Errors(): absolute{0}, squared{0}, hits{0} {}
+
+  /* The AVX2 kernels are compiled for AVX2 alone (the rest of the
+     build targets the baseline) and chosen once at startup if the CPU
+     has it; each handles whole vectors and leaves the tail rows to
+     the portable kernels. */
+#if defined(HAVE_IMMINTRIN_H) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_AVX2 __attribute__((target("avx2")))
+  const bool enabled = __builtin_cpu_supports("avx2");
+
+  const std::size_t lanes{4};
+
+  KERNELS_AVX2 std::size_t
+  add_avx2(double* out, const double* in, std::size_t n)
+  {
+    std::size_t i{0};
+    for (; i + lanes <= n; i += lanes)
+      {
+	_mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(out + i),
+						_mm256_loadu_pd(in + i)));
+      }
+    return i;
+  }
+
+  KERNELS_AVX2 std::size_t
+  subtract_avx2(double* out, const double* in, std::size_t n)
+  {
+    std::size_t i{0};
+    for (; i + lanes <= n; i += lanes)
+      {
+	_mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(out + i),
+						_mm256_loadu_pd(in + i)));
+      }
+    return i;
+  }
+
+  KERNELS_AVX2 std::size_t
+  multiply_avx2(double* out, const double* in, std::size_t n)
+  {
+    std::size_t i{0};
+    for (; i + lanes <= n; i += lanes)
+      {
+	_mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(out + i),
+						_mm256_loadu_pd(in + i)));
+      }
+    return i;
+  }
+
+  // Divides every lane, then blends in one where the divisor was zero.
+  KERNELS_AVX2 std::size_t
+  divide_avx2(double* out, const double* in, std::size_t n)
+  {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1);
+    std::size_t i{0};
+    for (; i + lanes <= n; i += lanes)
+      {
+	const __m256d divisor = _mm256_loadu_pd(in + i);
+	const __m256d quotient = _mm256_div_pd(_mm256_loadu_pd(out + i),
+					       divisor);
+	const __m256d zeros = _mm256_cmp_pd(divisor, zero, _CMP_EQ_OQ);
+	_mm256_storeu_pd(out + i, _mm256_blendv_pd(quotient, one, zeros));
+      }
+    return i;
+  }
+
+  /* The absolute error clears the sign bit; a hit is a lane whose
+     error compares (ordered, so never when not a number) within the
+     tolerance. */
+  KERNELS_AVX2 std::size_t
+  errors_avx2(const double* predicted, const double* observed, std::size_t n,
+	      double tolerance, Errors& errors)
+  {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d within = _mm256_set1_pd(tolerance);
+    __m256d absolute = _mm256_setzero_pd();
+    __m256d squared = _mm256_setzero_pd();
+    long hits{0};
+    std::size_t i{0};
+    for (; i + lanes <= n; i += lanes)
+      {
+	const __m256d error = _mm256_andnot_pd(
+	  sign, _mm256_sub_pd(_mm256_loadu_pd(predicted + i),
+			      _mm256_loadu_pd(observed + i)));
+	absolute = _mm256_add_pd(absolute, error);
+	squared = _mm256_add_pd(squared, _mm256_mul_pd(error, error));
+	hits += __builtin_popcount(_mm256_movemask_pd(
+	  _mm256_cmp_pd(error, within, _CMP_LE_OQ)));
+      }
+
+    double sums[lanes];
+    _mm256_storeu_pd(sums, absolute);
+    errors.absolute += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    _mm256_storeu_pd(sums, squared);
+    errors.squared += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    errors.hits += hits;
+    return i;
+  }
+#else
+  const bool enabled = false;
+
+  std::size_t
+  add_avx2(double*, const double*, std::size_t)
+  { return 0; }
+
+  std::size_t
+  subtract_avx2(double*, const double*, std::size_t)
+  { return 0; }
+
+  std::size_t
+  multiply_avx2(double*, const double*, std::size_t)
+  { return 0; }
+
+  std::size_t
+  divide_avx2(double*, const double*, std::size_t)
+  { return 0; }
+
+  std::size_t
+  errors_avx2(const double*, const double*, std::size_t, double, Errors&)
+  { return 0; }
+#endif
+
+  bool
+  avx2()
+  { return enabled; }
+
+  /* The portable kernels finish from row i; written as plain loops
+     (and division as a select) so the compiler may vectorize them for
+     the baseline. */
+  void
+  add(double* out, const double* in, std::size_t n)
+  {
+    for (std::size_t i{enabled ? add_avx2(out, in, n) : 0}; i < n; ++i)
+      { out[i] += in[i]; }
+  }
+
+  void
+  subtract(double* out, const double* in, std::size_t n)
+  {
+    for (std::size_t i{enabled ? subtract_avx2(out, in, n) : 0}; i < n; ++i)
+      { out[i] -= in[i]; }
+  }
+
+  void
+  multiply(double* out, const double* in, std::size_t n)
+  {
+    for (std::size_t i{enabled ? multiply_avx2(out, in, n) : 0}; i < n; ++i)
+      { out[i] *= in[i]; }
+  }
+
+  void
+  divide(double* out, const double* in, std::size_t n)
+  {
+    for (std::size_t i{enabled ? divide_avx2(out, in, n) : 0}; i < n; ++i)
+      {
+	const double quotient = out[i] / in[i];
+	out[i] = in[i] == 0 ? 1 : quotient;
+      }
+  }
+
+  void
+  fill(double* out, double value, std::size_t n)
+  {
+    for (std::size_t i{0}; i < n; ++i)
+      { out[i] = value; }
+  }
+
+  void
+  errors(const double* predicted, const double* observed, std::size_t n,
+	 double tolerance, Errors& errors)
+  {
+    std::size_t i{enabled
+	? errors_avx2(predicted, observed, n, tolerance, errors) : 0};
+    for (; i < n; ++i)
+      {
+	const double error = std::abs(predicted[i] - observed[i]);
+	errors.absolute += error;
+	errors.squared += error * error;
+	if (error <= tolerance)
+	  { ++errors.hits; }
+      }
+  }
+}
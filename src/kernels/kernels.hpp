@@ -0,0 +1,54 @@
+/* kernels.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for kernels namespace
+ * vectorized arithmetic over columns of rows, for regression
+ */
+
+#ifndef _KERNELS_H_
+#define _KERNELS_H_
+
+#include <cstddef>
+
+namespace kernels
+{
+  // Rows evaluated at once, so a tree's buffers stay in cache.
+  const std::size_t width{256};
+
+  // True if the AVX2 kernels are in use (built, and this CPU has it).
+  bool
+  avx2();
+
+  /* Each kernel combines n rows of in into out, in place.  Division
+     is protected, giving one where the divisor is zero, without
+     branching on it. */
+  void
+  add(double*, const double*, std::size_t);
+
+  void
+  subtract(double*, const double*, std::size_t);
+
+  void
+  multiply(double*, const double*, std::size_t);
+
+  void
+  divide(double*, const double*, std::size_t);
+
+  void
+  fill(double*, double, std::size_t);
+
+  // Sums of the errors of predictions against observations.
+  struct Errors
+  {
+    double absolute;
+    double squared;
+    long hits; // Predictions within tolerance.
+    Errors();
+  };
+
+  // Adds the errors of n predictions against observations.
+  void
+  errors(const double*, const double*, std::size_t, double, Errors&);
+}
+
+#endif /* _KERNELS_H_ */
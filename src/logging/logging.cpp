@@ -4,17 +4,26 @@
  * Source file for logging namespace
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <numeric>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "logging.hpp"
 #include "../individual/individual.hpp"
 #include "../options/options.hpp"
+#include "../problem/ant.hpp"
+#include "../problem/regression.hpp"
 
 namespace logging
 {
@@ -25,12 +34,13 @@ namespace logging
   // Opens the appropriate log file for given time, trial, and folder.
   void
   open_log(std::ofstream& log, const std::time_t& time, int trial,
-	   const std::string& folder)
+	   const std::string& folder, const std::string& extension,
+	   std::ios_base::openmode mode)
   {
     std::string filename = folder + std::to_string(time) + "_"
-      + std::to_string(trial) + ".dat";
+      + std::to_string(trial) + extension;
 
-    log.open(filename, std::ios_base::app);
+    log.open(filename, mode);
 
     if (not log) // TODO: throw exception instead
       {
@@ -39,7 +49,7 @@ namespace logging
       }
   }
 
-  void start_log(std::ofstream& log, const std::time_t& time,
+  void start_log(std::ostream& log, const std::time_t& time,
 		 const options::Options& options)
   {
     using std::setw;
@@ -47,11 +57,12 @@ namespace logging
 	<< std::ctime(&time)
 	<< "# generations: " << options.generations
 	<< ", population size: " << options.pop_size
-      	<< ", min depth: " << options.min_depth
+	<< ", min depth: " << options.min_depth
 	<< ", max depth: " << options.max_depth
-      	<< ", depth limit: " << options.depth_limit
+	<< ", depth limit: " << options.depth_limit
+	<< ", memory limit: " << options.memory_limit << " MB"
 	<< ", tournament size: " << options.tourney_size
-      	<< ", fitter size: " << options.fit_size
+	<< ", fitter size: " << options.fit_size
 	<< ", crossover size: " << options.crossover_size
 	<< ", elitism size: " << options.elitism_size
 	<< ", fitness penalty: " << options.penalty << " * total size"
@@ -59,7 +70,19 @@ namespace logging
 	<< ", over select chance: " << options.over_select_chance
 	<< ", mutate chance: " << options.mutate_chance
 	<< ", crossover chance: " << options.crossover_chance
-      	<< ", internals chance: " << options.internals_chance
+	<< ", internals chance: " << options.internals_chance
+	<< ", surrogate: " << options.surrogate
+	<< ", surrogate sample: " << options.surrogate_sample
+	<< ", problem: " << options.problem
+	<< ", maps: " << options.maps.size()
+	<< ", samples: " << (options.samples ? options.samples->size() : 0)
+	<< ", racing: " << std::boolalpha << options.racing
+	<< ", resume: " << options.resume
+	<< ", parallel size: " << options.parallel_size
+	<< ", jit: " << options.jit_threshold
+	<< ", interleave: " << options.interleave
+	<< ", profile: " << options.profile
+	<< ", pin: " << options.pin
 	<< std::left
 	<< setw(width) << "\n# gen"
 	<< setw(width) << "score"
@@ -70,19 +93,15 @@ namespace logging
 	<< setw(width) << "best dep"
 	<< setw(width) << "avg dep"
 	<< std::endl;
-    log.close();
   }
 
-  /* Log a line of relevant algorithm information (best and average
+  /* Summarize relevant algorithm information (best and average
      fitness and size plus adjusted best fitness). */
-  void
-  log_info(int verbosity, const std::string& logs_dir, const std::time_t& time,
-	   int trial, int generation, const Individual& best,
-	   const std::vector<Individual>& pop)
+  template<typename Problem> Record
+  summarize(int generation, const Individual<Problem>& best,
+	    const std::vector<Individual<Problem>>& pop)
   {
-    // Be a noop if verbosity is zero
-    if (verbosity == 0)
-      { return; }
+    typedef Individual<Problem> Individual;
 
     float total_fitness =
       std::accumulate(begin(pop), end(pop), 0., [](float a, const Individual& b)
@@ -96,19 +115,214 @@ namespace logging
       std::accumulate(begin(pop), end(pop), 0, [](int a, const Individual& b)
 		      { return a + b.get_depth(); });
 
-    std::ofstream log;
+    return Record{generation, best.get_score(), best.get_adjusted(),
+	total_fitness / pop.size(), best.get_total(),
+	static_cast<float>(total_size) / pop.size(), best.get_depth(),
+	static_cast<float>(total_depth) / pop.size()};
+  }
+
+  template Record
+  summarize(int, const Individual<problem::Ant>&,
+	    const std::vector<Individual<problem::Ant>>&);
+
+  template Record
+  summarize(int, const Individual<problem::Regression>&,
+	    const std::vector<Individual<problem::Regression>>&);
+
+  // Log a line of a generation's record.
+  void
+  log_info(std::ostream& log, const Record& record)
+  {
     using std::setw;
-    open_log(log, time, trial, logs_dir);
     log << std::setprecision(4) << std::left
-	<< setw(width) << generation
-	<< setw(width) << best.get_score()
-	<< setw(width) << best.get_adjusted()
-	<< setw(width) << total_fitness / pop.size()
-	<< setw(width) << best.get_total()
-	<< setw(width) << static_cast<float>(total_size) / pop.size()
-	<< setw(width) << best.get_depth()
-	<< setw(width) << static_cast<float>(total_depth) / pop.size()
-	<< std::endl;
-    log.close();
+	<< setw(width) << record.generation
+	<< setw(width) << record.score
+	<< setw(width) << record.best_fitness
+	<< setw(width) << record.avg_fitness
+	<< setw(width) << record.best_size
+	<< setw(width) << record.avg_size
+	<< setw(width) << record.best_depth
+	<< setw(width) << record.avg_depth
+	<< '\n';
+  }
+
+  namespace binary
+  {
+    static_assert(sizeof(Record) == 32 and sizeof(Record) % width == 0,
+		  "Records must pack into binary logs");
+
+    typedef std::uint32_t length_t;
+
+    // Rounds up to the alignment of records.
+    std::size_t
+    aligned(std::size_t offset)
+    { return (offset + width - 1) / width * width; }
+
+    void
+    start(std::ofstream& log, const std::time_t& time, int trial,
+	  const options::Options& options)
+    {
+      open_log(log, time, trial, options.logs_dir, ".bin", std::ios_base::out
+	       | std::ios_base::trunc | std::ios_base::binary);
+
+      std::ostringstream text;
+      start_log(text, time, options);
+      const std::string header = text.str();
+      const length_t length = header.size();
+      const std::size_t offset = width + sizeof(length) + length;
+
+      log.write(magic, width);
+      log.write(reinterpret_cast<const char*>(&length), sizeof(length));
+      log << header << std::string(aligned(offset) - offset, '\0');
+    }
+
+    std::string
+    footer(const std::string& text)
+    {
+      const length_t length = text.size();
+      return text + std::string(reinterpret_cast<const char*>(&length),
+				sizeof(length)) + std::string(end, width);
+    }
+
+    /* A log whose trial is still running (or was killed) has no
+       footer, in which case every whole record after the header is
+       read. */
+    View
+    view(const std::string& filename, const char* data, std::size_t size)
+    {
+      length_t length;
+      std::size_t first{width + sizeof(length)};
+      if (size < first or std::memcmp(data, magic, width) != 0)
+	{ throw std::runtime_error{"File " + filename + " is not a binary log!"}; }
+      std::memcpy(&length, data + width, sizeof(length));
+      if (length > size - first)
+	{ throw std::runtime_error{"File " + filename + " had a bad header!"}; }
+
+      View view;
+      view.header.assign(data + first, length);
+      first = std::min(aligned(first + length), size);
+
+      std::size_t last{size};
+      const std::size_t trailer{sizeof(length) + width};
+      if (size - first >= trailer
+	  and std::memcmp(data + size - width, end, width) == 0)
+	{
+	  std::memcpy(&length, data + size - trailer, sizeof(length));
+	  if (length > size - first - trailer)
+	    { throw std::runtime_error{"File " + filename + " had a bad footer!"}; }
+	  last = size - trailer - length;
+	  view.footer.assign(data + last, length);
+	}
+
+      view.records = reinterpret_cast<const Record*>(data + first);
+      view.count = (last - first) / sizeof(Record);
+      return view;
+    }
+  }
+
+  Channel::Channel(std::ofstream&& file, bool binary):
+    head{0}, tail{0}, closed{false}, log{std::move(file)}, binary{binary} {}
+
+  // Push a record, waiting for the logger only if the buffer is full.
+  void
+  Channel::push(const Record& record)
+  {
+    const std::size_t h = head.load(std::memory_order_relaxed);
+    while (h - tail.load(std::memory_order_acquire) == capacity)
+      { std::this_thread::yield(); }
+    records[h % capacity] = record;
+    head.store(h + 1, std::memory_order_release);
+  }
+
+  /* Finish the log with a footer, waking the logger, and wait until
+     it has written out the rest and closed the file. */
+  void
+  Channel::close(const std::string& text)
+  {
+    footer = binary ? binary::footer(text) : text;
+    std::future<void> done = drained.get_future();
+    closed.store(true, std::memory_order_release);
+    Logger::instance().wake.notify_one();
+    done.wait();
+  }
+
+  /* Write out every pushed record, returning true once closed and
+     fully drained (after writing the footer and closing the file). */
+  bool
+  Channel::drain()
+  {
+    const bool finished = closed.load(std::memory_order_acquire);
+    const std::size_t h = head.load(std::memory_order_acquire);
+    std::size_t t = tail.load(std::memory_order_relaxed);
+    if (binary)
+      while (t != h)
+	{
+	  // Each contiguous run of the ring in one write.
+	  const std::size_t first = t % capacity;
+	  const std::size_t run = std::min(h - t, capacity - first);
+	  log.write(reinterpret_cast<const char*>(records + first),
+		    run * sizeof(Record));
+	  t += run;
+	}
+    else
+      for (; t != h; ++t)
+	{ log_info(log, records[t % capacity]); }
+    tail.store(t, std::memory_order_release);
+
+    if (finished)
+      {
+	log << footer;
+	log.close();
+	drained.set_value();
+      }
+    else
+      { log.flush(); }
+    return finished;
+  }
+
+  Logger::Logger(): stopping{false}, thread{&Logger::run, this} {}
+
+  // The logger is started on first use and stopped at exit.
+  Logger&
+  Logger::instance()
+  {
+    static Logger logger;
+    return logger;
+  }
+
+  std::shared_ptr<Channel>
+  Logger::open(std::ofstream&& log, bool binary)
+  {
+    auto channel = std::make_shared<Channel>(std::move(log), binary);
+    std::lock_guard<std::mutex> lock{mutex};
+    channels.push_back(channel);
+    return channel;
+  }
+
+  // Drain channels in batches, dropping finished ones, until stopped.
+  void
+  Logger::run()
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+    while (true)
+      {
+	const bool last = stopping;
+	auto done = [](const std::shared_ptr<Channel>& c) { return c->drain(); };
+	channels.erase(remove_if(begin(channels), end(channels), done),
+		       end(channels));
+	if (last)
+	  { return; }
+	wake.wait_for(lock, std::chrono::milliseconds{50});
+      }
+  }
+
+  Logger::~Logger()
+  {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
   }
 }
@@ -7,29 +7,138 @@
 #ifndef _LOGGING_H_
 #define _LOGGING_H_
 
-#include <string>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <ctime>
+#include <fstream>
+#include <future>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 // Forward declarations
-namespace individual { class Individual; }
+namespace individual { template<typename Problem> class Individual; }
 namespace options { struct Options; }
 
 namespace logging
 {
   // Opens the appropriate log file for given time, trial, and folder.
   void
-  open_log(std::ofstream&, const std::time_t&, int, const std::string&);
+  open_log(std::ofstream&, const std::time_t&, int, const std::string&,
+	   const std::string& extension = ".dat",
+	   std::ios_base::openmode mode = std::ios_base::app);
 
   // Logs initial parameters from options object.
   void
-  start_log(std::ofstream&, const std::time_t&, const options::Options&);
+  start_log(std::ostream&, const std::time_t&, const options::Options&);
+
+  // Pre-computed statistics of one generation, as logged.
+  struct Record
+  {
+    int generation;
+    int score;
+    float best_fitness;
+    float avg_fitness;
+    int best_size;
+    float avg_size;
+    int best_depth;
+    float avg_depth;
+  };
+
+  // Summarizes the current population for logging.
+  template<typename Problem> Record
+  summarize(int, const individual::Individual<Problem>&,
+	    const std::vector<individual::Individual<Problem>>&);
 
-  // Logs info about current population.
+  // Logs a generation's record as a line of text.
   void
-  log_info(int, const std::string&, const std::time_t&, int, int,
-	   const individual::Individual&,
-	   const std::vector<individual::Individual>&);
+  log_info(std::ostream&, const Record&);
+
+  /* A binary log (see --log-format) is the magic, the 32-bit length
+     of its text header (as start_log writes it) and the header, padded
+     to 8 bytes; then each generation's Record as is (in native byte
+     order); then its text footer, the footer's length and the end
+     magic.  Exported as the text log by the dump program. */
+  namespace binary
+  {
+    const char magic[] = "ANTGPLOG";
+    const char end[] = "ANTGPEND";
+    const std::size_t width{8}; // Of the magics, and the alignment.
+
+    // The parts of a binary log in memory (say, mapped).
+    struct View
+    {
+      std::string header;
+      const Record* records;
+      std::size_t count;
+      std::string footer; // Empty if the trial never finished.
+    };
+
+    // Opens the binary log and writes its header.
+    void
+    start(std::ofstream&, const std::time_t&, int,
+	  const options::Options&);
+
+    // The framed footer, finishing the binary log.
+    std::string
+    footer(const std::string&);
+
+    // Views the named binary log, throwing std::runtime_error if bad.
+    View
+    view(const std::string&, const char*, std::size_t);
+  }
+
+  /* Lock-free single producer, single consumer ring buffer of one
+     trial's records, along with its open log file.  The trial pushes
+     records and finally closes it with a footer; the logger thread
+     drains it into the file, which close waits for, so the file is
+     complete once the trial is. */
+  class Channel
+  {
+  public:
+    Channel(std::ofstream&&, bool binary);
+    void push(const Record&);
+    void close(const std::string&);
+
+  private:
+    friend class Logger;
+    static const std::size_t capacity{1024};
+    Record records[capacity];
+    std::atomic<std::size_t> head;
+    std::atomic<std::size_t> tail;
+    std::atomic<bool> closed;
+    std::string footer;
+    std::ofstream log;
+    const bool binary;
+    std::promise<void> drained;
+    bool drain();
+  };
+
+  /* The single writer of every trial's log: a persistent thread which
+     periodically drains all open channels, flushing each file once
+     per batch, until the process exits. */
+  class Logger
+  {
+    friend class Channel;
+
+  public:
+    static Logger& instance();
+    std::shared_ptr<Channel> open(std::ofstream&&, bool binary = false);
+    ~Logger();
+
+  private:
+    Logger();
+    void run();
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+    std::vector<std::shared_ptr<Channel>> channels;
+    std::thread thread;
+  };
 }
 
 #endif /* _LOGGING_H_ */
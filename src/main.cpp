@@ -11,37 +11,59 @@
 #include "algorithm/algorithm.hpp"
 #include "individual/individual.hpp"
 #include "options/options.hpp"
+#include "problem/ant.hpp"
+#include "problem/regression.hpp"
 #include "random_generator/random_generator.hpp"
+#include "sweep/sweep.hpp"
 #include "trials/trials.hpp"
 
-int
-main(int argc, char* argv[])
+namespace
 {
-  // Retrieve program options.
-  const options::Options options = options::parse(argc, argv);
+  // Runs the trials of the given problem, printing the best result.
+  template<typename Problem> void
+  search(const options::Options& options)
+  {
+    // Chrono start, end, and Unix time variables.
+    std::chrono::time_point<std::chrono::system_clock> start, end;
+    std::time_t time = std::time(nullptr);
+
+    // Begin timing trials.
+    start = std::chrono::system_clock::now();
 
-  // Chrono start, end, and Unix time variables.
-  std::chrono::time_point<std::chrono::system_clock> start, end;
-  std::time_t time = std::time(nullptr);
+    // Run trials and save best Individual.
+    int best_index;
+    algorithm::result_t<Problem> best;
+    std::tie(best_index, best) = trials::run<Problem>(time, options);
 
-  // Begin timing trials.
-  start = std::chrono::system_clock::now();
+    // End timing trials.
+    end = std::chrono::system_clock::now();
+    std::chrono::duration<double> elapsed_seconds = end - start;
 
-  // Run trials and save best Individual.
-  int best_index;
-  algorithm::result_t best;
-  std::tie(best_index, best) = trials::run(time, options);
+    // Print total time info and which trial was best.
+    std::cout << "Total elapsed time: " << elapsed_seconds.count() << "s\n"
+	      << "Average time: " << elapsed_seconds.count() / options.trials
+	      << "s\nBest trial: " << time << "_"
+	      << best_index << "\n"
+	      << std::get<0>(best).print();
+  }
+}
 
-  // End timing trials.
-  end = std::chrono::system_clock::now();
-  std::chrono::duration<double> elapsed_seconds = end - start;
+int
+main(int argc, char* argv[])
+{
+  // Retrieve program options.
+  const options::Options options = options::parse(argc, argv);
 
-  // Print total time info and which trial was best.
-  std::cout << "Total elapsed time: " << elapsed_seconds.count() << "s\n"
-	    << "Average time: " << elapsed_seconds.count() / options.trials
-	    << "s\nBest trial: " << time << "_"
-	    << best_index << "\n"
-	    << std::get<0>(best).print();
+  // A sweep runs each of its parameter sets instead.
+  const std::time_t time = std::time(nullptr);
+  if (not options.sweep.empty() and options.problem == "regression")
+    { sweep::run<problem::Regression>(time, argc, argv, options); }
+  else if (not options.sweep.empty())
+    { sweep::run<problem::Ant>(time, argc, argv, options); }
+  else if (options.problem == "regression")
+    { search<problem::Regression>(options); }
+  else
+    { search<problem::Ant>(options); }
 
   return EXIT_SUCCESS;
 }
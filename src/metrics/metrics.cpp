@@ -0,0 +1,81 @@
+/* metrics.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for metrics namespace
+ */
+
+#include <sstream>
+
+#include "metrics.hpp"
+
+namespace metrics
+{
+  const int phases = static_cast<int>(Phase::count);
+  const int counters = static_cast<int>(Counter::count);
+
+  const char* phase_names[phases] = {"selection", "sort", "crossover",
+				     "mutation", "evaluation", "elitism",
+				     "logging"};
+
+  const char* counter_names[counters] = {"ticks", "nodes", "evaluations",
+					 "copies"};
+
+  Totals::Totals(): seconds{}, counts{} {}
+
+  Totals
+  Totals::operator-(const Totals& b) const
+  {
+    Totals difference;
+    for (int p{0}; p < phases; ++p)
+      { difference.seconds[p] = seconds[p] - b.seconds[p]; }
+    for (int c{0}; c < counters; ++c)
+      { difference.counts[c] = counts[c] - b.counts[c]; }
+    return difference;
+  }
+
+  thread_local Totals totals;
+
+  // Innermost running timer of this thread.
+  thread_local Timer* running{nullptr};
+
+  Totals&
+  current()
+  { return totals; }
+
+  // Starting a timer pauses the one it is nested in.
+  Timer::Timer(Phase p): phase{p}, start{clock::now()}, outer{running}
+  {
+    if (outer)
+      { outer->stop(start); }
+    running = this;
+  }
+
+  Timer::~Timer()
+  {
+    const clock::time_point now = clock::now();
+    stop(now);
+    running = outer;
+    if (outer)
+      { outer->start = now; }
+  }
+
+  void
+  Timer::stop(clock::time_point now)
+  {
+    const std::chrono::duration<double> elapsed = now - start;
+    totals.seconds[static_cast<int>(phase)] += elapsed.count();
+  }
+
+  std::string
+  json(int trial, int generation, const Totals& t)
+  {
+    std::stringstream out;
+    out << "{\"trial\": " << trial << ", \"generation\": " << generation;
+    for (int p{0}; p < phases; ++p)
+      { out << ", \"" << phase_names[p] << "_seconds\": " << t.seconds[p]; }
+    for (int c{0}; c < counters; ++c)
+      { out << ", \"" << counter_names[c] << "\": " << t.counts[c]; }
+    out << "}";
+    return out.str();
+  }
+}
@@ -0,0 +1,77 @@
+/* metrics.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for metrics namespace
+ * times the algorithm's phases and counts its work, per thread
+ */
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <chrono>
+#include <string>
+
+/* Instrumentation is compiled in with ./configure --enable-metrics;
+   otherwise these macros expand to nothing. */
+#ifdef ENABLE_METRICS
+#define METRICS_TIME(phase) \
+  metrics::Timer metrics_timer{metrics::Phase::phase}
+#define METRICS_COUNT(counter, n) \
+  metrics::add(metrics::Counter::counter, n)
+#else
+#define METRICS_TIME(phase)
+#define METRICS_COUNT(counter, n)
+#endif
+
+namespace metrics
+{
+  enum class Phase { selection, sort, crossover, mutation, evaluation,
+      elitism, logging, count };
+
+  enum class Counter { ticks, nodes, evaluations, copies, count };
+
+  // Seconds spent in each phase and counts of work done.
+  struct Totals
+  {
+    double seconds[static_cast<int>(Phase::count)];
+    unsigned long long counts[static_cast<int>(Counter::count)];
+    Totals();
+    Totals operator-(const Totals&) const;
+  };
+
+  // The calling thread's (that is, trial's) totals.
+  Totals&
+  current();
+
+  inline void
+  add(Counter counter, unsigned long long n)
+  { current().counts[static_cast<int>(counter)] += n; }
+
+  /* Times its scope as the given phase, exclusive of any phases timed
+     within it (such as evaluation of a brood during crossover). */
+  class Timer
+  {
+  public:
+    Timer(Phase);
+    ~Timer();
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+  private:
+    typedef std::chrono::steady_clock clock;
+    Phase phase;
+    clock::time_point start;
+    Timer* outer;
+    void stop(clock::time_point);
+  };
+
+  // Returns totals as a JSON object for the given trial and generation.
+  std::string
+  json(int trial, int generation, const Totals&);
+}
+
+#endif /* _METRICS_H_ */
@@ -0,0 +1,166 @@
+/* observe.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Shows the live statistics a search publishes with --telemetry.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+
+#include "telemetry/telemetry.hpp"
+
+// Resident megabytes of the process, or -1 if it is gone.
+double
+resident(long pid)
+{
+  std::ifstream statm{"/proc/" + std::to_string(pid) + "/statm"};
+  long pages, resident;
+  if (not (statm >> pages >> resident))
+    { return -1; }
+  return resident * (sysconf(_SC_PAGESIZE) / 1048576.);
+}
+
+// Seconds of the monotonic clock, as the search publishes them.
+double
+now()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Prints a table of every published trial, running ones first.
+void
+show(const telemetry::Page& page)
+{
+  using std::setw;
+
+  const double memory = resident(page.pid);
+  std::cout << "search " << page.pid;
+  if (memory < 0)
+    { std::cout << " (exited)\n"; }
+  else
+    { std::cout << ", " << std::fixed << std::setprecision(1) << memory
+		<< " MB resident\n"; }
+
+  std::cout << std::left << setw(8) << "trial" << setw(10) << "state"
+	    << std::right << setw(8) << "gen" << setw(8) << "score"
+	    << setw(10) << "avg size" << setw(12) << "evals/s"
+	    << setw(10) << "trees MB" << setw(10) << "seconds"
+	    << setw(8) << "idle" << '\n';
+
+  const double time = now();
+  for (const bool running : {true, false})
+    for (const auto& slot : page.slots)
+      {
+	telemetry::Snapshot s;
+	if (not telemetry::read(slot, s) or s.running != running)
+	  { continue; }
+	const char* state = not running ? "finished"
+	  : slot.stop.load(std::memory_order_relaxed) ? "stopping"
+	  : memory < 0 ? "lost" : "running";
+	std::cout << std::left << setw(8) << s.trial << setw(10) << state
+		  << std::right << setw(8) << s.generation << setw(8) << s.score
+		  << std::setprecision(1) << setw(10) << s.avg_size
+		  << std::setprecision(0) << setw(12) << s.rate
+		  << std::setprecision(1) << setw(10) << s.bytes / 1048576.
+		  << setw(10) << s.seconds
+		  << setw(8) << (running ? time - s.updated : 0) << '\n';
+      }
+}
+
+int
+main(int argc, char* argv[])
+{
+  using std::string;
+  using namespace boost::program_options;
+
+  string path;
+  double interval;
+  std::vector<int> stops;
+
+  options_description description{"Allowed options"};
+  description.add_options()
+    ("help,h", "produce help message")
+    ("telemetry,f", value<string>(&path)->required(),
+     "set the file the search publishes to (its --telemetry)")
+    ("interval,n", value<double>(&interval)->default_value(1),
+     "set the seconds between refreshes")
+    ("once,1", "print the statistics once and exit")
+    ("stop,s", value<std::vector<int>>(&stops)->composing(),
+     "stop the given running trial after its generation, and exit");
+
+  positional_options_description positionals;
+  positionals.add("telemetry", 1);
+
+  variables_map variables_map;
+  try
+    {
+      store(command_line_parser(argc, argv).options(description)
+	    .positional(positionals).run(), variables_map);
+      if (variables_map.count("help"))
+	{
+	  std::cout << "Usage: antgp-observe <telemetry file> [--once] [--stop <trial>]\n\n"
+		    << description << std::endl;
+	  return EXIT_SUCCESS;
+	}
+      notify(variables_map);
+    }
+  catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  telemetry::Page* page;
+  try
+    { page = telemetry::map(path, false); }
+  catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  // Flag each trial to stop; it does so after its current generation.
+  if (not stops.empty())
+    {
+      int status{EXIT_SUCCESS};
+      for (const int trial : stops)
+	{
+	  auto* slot = trial >= 0 ? &page->slots[telemetry::index(trial)] : nullptr;
+	  telemetry::Snapshot s;
+	  if (slot and telemetry::read(*slot, s) and s.trial == trial
+	      and s.running)
+	    { slot->stop.store(1, std::memory_order_relaxed); }
+	  else
+	    {
+	      std::cerr << "Trial " << trial << " is not running!\n";
+	      status = EXIT_FAILURE;
+	    }
+	}
+      return status;
+    }
+
+  while (true)
+    {
+      if (not variables_map.count("once"))
+	{ std::cout << "\033[H\033[2J"; }
+      show(*page);
+      std::cout << std::flush;
+      if (variables_map.count("once"))
+	{ return EXIT_SUCCESS; }
+      std::this_thread::sleep_for(std::chrono::duration<double>{interval});
+    }
+}
@@ -4,114 +4,565 @@
  * Source file for options namespace
  */
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <boost/program_options.hpp>
 
 #include "options.hpp"
+#include "../generator/generator.hpp"
 
 namespace options
 {
   Position::Position(): x{0}, y{0}, direction{Direction::east} {}
 
-  Map::Map(): max_ticks{0}, ticks{0}, width{0}, height{0}, score{0}, pieces{0},
-	      position{Position{}} {}
+  /* Accumulates food into tiles one row at a time, appending a band
+     of directory entries every 64 rows.  The first tile is the
+     shared empty tile. */
+  struct Builder
+  {
+    std::size_t width;
+    std::size_t height;
+    std::size_t columns;
+    int pieces;
+    std::vector<std::uint32_t> directory;
+    std::vector<std::uint64_t> words;
 
-  Map::Map(const std::string& filename, int ticks):
-    max_ticks{ticks}, ticks{0}, width{0}, height{0}, score{0}, pieces{0},
-    position{Position{}}
+    Builder(std::size_t w): width{w}, height{0}, columns{(w + 63) / 64},
+			    pieces{0}, words(64, 0) {}
+
+    // Starts the next row, returning its index.
+    std::size_t
+    row()
+    {
+      if (height % 64 == 0)
+	{ directory.resize(directory.size() + columns, 0); }
+      return height++;
+    }
+
+    void
+    add(std::size_t x, std::size_t y)
+    {
+      std::uint32_t& tile = directory[(y / 64) * columns + x / 64];
+      if (tile == 0) // Give this tile its own bits.
+	{
+	  tile = words.size() / 64;
+	  words.resize(words.size() + 64, 0);
+	}
+      std::uint64_t& word = words[tile * 64 + y % 64];
+      const std::uint64_t bit = std::uint64_t{1} << (x % 64);
+      if (not (word & bit))
+	{
+	  word |= bit;
+	  ++pieces;
+	}
+    }
+  };
+
+  // Header of a binary map file, followed by directory and tiles.
+  struct Header
+  {
+    char magic[8];
+    std::uint64_t width;
+    std::uint64_t height;
+    std::uint64_t pieces;
+    std::uint64_t tiles;
+  };
+
+  const char binary_magic[8] = {'A', 'N', 'T', 'M', 'A', 'P', '\0', '\1'};
+
+  // Bytes of a directory, padded so the tiles after it stay aligned.
+  std::size_t
+  directory_bytes(std::size_t entries)
+  { return (entries * sizeof(std::uint32_t) + 7) / 8 * 8; }
+
+  Mapping::Mapping(const std::string& filename): data{nullptr}, size{0}
   {
-    // Try to open the given file.
-    std::ifstream data_file{filename};
-    if (not data_file) // TODO: throw exception
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+      { throw std::runtime_error{"File " + filename + " could not be read!"}; }
+
+    struct stat status;
+    if (fstat(fd, &status) == 0 and status.st_size > 0)
       {
-	std::cerr << "File " << filename << " could not be read!\n";
-	std::exit(EXIT_FAILURE);
+	size = status.st_size;
+	void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (address != MAP_FAILED)
+	  {
+	    data = static_cast<const char*>(address);
+	    madvise(address, size, MADV_SEQUENTIAL);
+	  }
       }
+    close(fd);
 
-    // Parse file into map structure
-    std::string line;
-    while (data_file >> line)
+    if (data == nullptr)
+      { throw std::runtime_error{"File " + filename + " could not be mapped!"}; }
+  }
+
+  Mapping::~Mapping()
+  { munmap(const_cast<char*>(data), size); }
+
+  // Parses mapped text of '.' (blank) and 'x' (food) cells in one pass.
+  Builder
+  parse_text(const Mapping& file, const std::string& filename)
+  {
+    const char* c = file.data;
+    const char* const end = file.data + file.size;
+    auto blank = [](char c) { return std::isspace(static_cast<unsigned char>(c)); };
+
+    Builder builder{0};
+    while (true)
       {
-	std::vector<Cell> row;
-	if (width != 0) row.reserve(width);
-	for (const char& c : line)
+	while (c != end and blank(*c))
+	  { ++c; }
+	if (c == end)
+	  { break; }
+
+	// Find this line's width, which the first line sets for all.
+	const char* line = c;
+	while (c != end and not blank(*c))
+	  { ++c; }
+	const std::size_t width = c - line;
+	if (builder.height == 0)
+	  { builder = Builder{width}; }
+	else if (width != builder.width)
 	  {
-	    if (c != '.' and c != 'x') // TODO: throw exception
-	      {
-		std::cerr << "File " << filename << " had bad cells!\n"
-			  << "They were: " << c << std::endl;
-		std::exit(EXIT_FAILURE);
-	      }
-	    else
-	      {
-		Cell cell = (c == 'x') ? Cell{Cell::food} : Cell{Cell::blank};
-		row.push_back(cell);
-		if (cell == Cell::food)
-		  { ++pieces; }
-	      }
+	    throw std::runtime_error{"File " + filename + " had uneven lines!\n"
+		"The width is: " + std::to_string(builder.width)
+		+ " and the line was " + std::to_string(width)};
 	  }
-	if (width == 0) // Get initial width
-	  { width = row.size(); }
-	// Verify all lines are same width
-	else if (row.size() != width) // TODO: throw exception
+
+	const std::size_t y = builder.row();
+	for (std::size_t x{0}; x < width; ++x)
 	  {
-	    std::cerr << "File " << filename << " had uneven lines!\n"
-		      << "The width is: " << width
-		      << " and the line was " << row.size() << std::endl;
-	    std::exit(EXIT_FAILURE);
+	    if (line[x] == 'x')
+	      { builder.add(x, y); }
+	    else if (line[x] != '.')
+	      {
+		throw std::runtime_error{"File " + filename + " had bad cells!\n"
+		    "They were: " + std::string{line[x]}};
+	      }
 	  }
-	rows.push_back(row);
       }
-    height = rows.size();
+
+    if (builder.height == 0)
+      { throw std::runtime_error{"File " + filename + " had no cells!"}; }
+    return builder;
+  }
+
+  Tiles::Tiles(): width{0}, height{0}, columns{0}, tiles{0}, pieces{0},
+		  directory{nullptr}, words{nullptr} {}
+
+  // Packs a grid's rows into tiles, with food where the predicate holds.
+  template<typename Row, typename Food> Builder
+  pack(const std::vector<Row>& grid, Food food)
+  {
+    Builder builder{grid.empty() ? 0 : grid.front().size()};
+    for (const auto& row : grid)
+      {
+	assert(row.size() == builder.width);
+	const std::size_t y = builder.row();
+	for (std::size_t x{0}; x < row.size(); ++x)
+	  if (food(row[x]))
+	    { builder.add(x, y); }
+      }
+    return builder;
+  }
+
+  Tiles::Tiles(const std::vector<std::vector<Cell>>& grid): Tiles{}
+  {
+    source = "generated";
+    adopt(pack(grid, [](Cell cell) { return cell == Cell::food; }));
+  }
+
+  // Tiles from a grid of bits, true where there is food.
+  Tiles::Tiles(const std::vector<std::vector<bool>>& grid,
+	       const std::string& name): Tiles{}
+  {
+    source = name;
+    adopt(pack(grid, [](bool food) { return food; }));
+  }
+
+  // Takes ownership of a builder's directory and tiles.
+  template<typename B> void
+  Tiles::adopt(B&& built)
+  {
+    auto owner = std::make_shared<B>(std::move(built));
+    width = owner->width;
+    height = owner->height;
+    columns = owner->columns;
+    tiles = owner->words.size() / 64;
+    pieces = owner->pieces;
+    directory = owner->directory.data();
+    words = owner->words.data();
+    storage = owner;
+  }
+
+  /* A copy of these tiles in memory written (so, under Linux's
+     default first-touch policy, allocated on the node of) the calling
+     thread. */
+  std::shared_ptr<const Tiles>
+  Tiles::local() const
+  {
+    Builder copy{width};
+    copy.height = height;
+    copy.pieces = pieces;
+    const std::size_t entries = columns * ((height + 63) / 64);
+    copy.directory.assign(directory, directory + entries);
+    copy.words.assign(words, words + tiles * 64);
+    std::shared_ptr<Tiles> local{new Tiles};
+    local->adopt(std::move(copy));
+    local->source = source;
+    return local;
+  }
+
+  /* Loads tiles from a map file: binary files (starting with the
+     magic bytes) are used in place from their mapping, while text
+     files are parsed from theirs.  Throws std::runtime_error for
+     unreadable or malformed files. */
+  std::shared_ptr<const Tiles>
+  Tiles::load(const std::string& filename)
+  {
+    auto file = std::make_shared<const Mapping>(filename);
+    std::shared_ptr<Tiles> loaded{new Tiles};
+
+    if (file->size < sizeof(Header)
+	or not std::equal(binary_magic, binary_magic + 8, file->data))
+      {
+	loaded->adopt(parse_text(*file, filename));
+	loaded->source = filename;
+	return loaded;
+      }
+
+    Header header;
+    std::memcpy(&header, file->data, sizeof(Header));
+    const std::size_t columns = (header.width + 63) / 64;
+    const std::size_t entries = columns * ((header.height + 63) / 64);
+    const std::size_t offset = sizeof(Header) + directory_bytes(entries);
+    if (header.tiles == 0
+	or file->size != offset + header.tiles * 64 * sizeof(std::uint64_t))
+      { throw std::runtime_error{"File " + filename + " had a bad size!"}; }
+
+    loaded->width = header.width;
+    loaded->height = header.height;
+    loaded->columns = columns;
+    loaded->tiles = header.tiles;
+    loaded->pieces = header.pieces;
+    loaded->directory =
+      reinterpret_cast<const std::uint32_t*>(file->data + sizeof(Header));
+    loaded->words = reinterpret_cast<const std::uint64_t*>(file->data + offset);
+    loaded->storage = file;
+    loaded->source = filename;
+
+    if (not std::all_of(loaded->directory, loaded->directory + entries,
+			[&header](std::uint32_t tile) { return tile < header.tiles; }))
+      { throw std::runtime_error{"File " + filename + " had bad tiles!"}; }
+
+    return loaded;
+  }
+
+  /* Writes the binary map format: a header of magic bytes, width,
+     height, pieces and tile count; the directory of tile numbers (row
+     major, zero padded to eight bytes); and the tiles of 64 words, one
+     per row with the first column in the lowest bit.  Integers are
+     native (little) endian, and tile zero is always the empty tile. */
+  void
+  Tiles::save(std::ostream& out) const
+  {
+    Header header;
+    std::copy(binary_magic, binary_magic + 8, header.magic);
+    header.width = width;
+    header.height = height;
+    header.pieces = pieces;
+    header.tiles = tiles;
+
+    const std::size_t entries = columns * ((height + 63) / 64);
+    const std::vector<char> padding(directory_bytes(entries)
+				    - entries * sizeof(std::uint32_t), 0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    out.write(reinterpret_cast<const char*>(directory),
+	      entries * sizeof(std::uint32_t));
+    out.write(padding.data(), padding.size());
+    out.write(reinterpret_cast<const char*>(words),
+	      tiles * 64 * sizeof(std::uint64_t));
+  }
+
+  // Writes the text map format of '.' and 'x' cells.
+  void
+  Tiles::print(std::ostream& out) const
+  {
+    std::string line(width, '.');
+    for (std::size_t y{0}; y < height; ++y)
+      {
+	for (std::size_t x{0}; x < width; ++x)
+	  { line[x] = food(x, y) ? 'x' : '.'; }
+	out << line << '\n';
+      }
+  }
+
+  // True if there is food at the given cell.
+  bool
+  Tiles::food(std::size_t x, std::size_t y) const
+  {
+    const std::uint32_t tile = directory[(y / 64) * columns + x / 64];
+    return (words[tile * 64 + y % 64] >> (x % 64)) & 1;
+  }
+
+  // Prefetches the word holding the given cell.
+  void
+  Tiles::prefetch(std::size_t x, std::size_t y) const
+  {
+    const std::uint32_t tile = directory[(y / 64) * columns + x / 64];
+    __builtin_prefetch(&words[tile * 64 + y % 64]);
+  }
+
+  std::size_t
+  Tiles::get_width() const
+  { return width; }
+
+  std::size_t
+  Tiles::get_height() const
+  { return height; }
+
+  int
+  Tiles::get_pieces() const
+  { return pieces; }
+
+  // Name of the file the tiles were loaded from, if any.
+  const std::string&
+  Tiles::get_source() const
+  { return source; }
+
+  // Bytes used by the directory and tiles.
+  std::size_t
+  Tiles::memory() const
+  {
+    return directory_bytes(columns * ((height + 63) / 64))
+      + tiles * 64 * sizeof(std::uint64_t);
+  }
+
+  // Extends the last run of actions, or starts a new one.
+  void
+  Trace::record(Action action)
+  {
+    if (not actions.empty() and actions.back().first == action)
+      { ++actions.back().second; }
+    else
+      { actions.emplace_back(action, 1); }
+  }
+
+  // Returns the actions and eaten ticks as "actions F3 L1 ..." and "eaten 0 4 ...".
+  std::string
+  Trace::print() const
+  {
+    std::stringstream out;
+    out << "actions";
+    for (const auto& run : actions)
+      { out << ' ' << static_cast<char>(run.first) << run.second; }
+    out << "\neaten";
+    for (int tick : eaten)
+      { out << ' ' << tick; }
+    out << '\n';
+    return out.str();
+  }
+
+  const std::uint64_t empty_slot = ~std::uint64_t{0};
+
+  // Maps of at most this many cells track visits in a bitset.
+  const std::size_t dense_cells = std::size_t{1} << 16;
+
+  Visited::Visited(): count{0}, shift{64} {}
+
+  /* A set of a map's cells: a bitset of them when small enough (8 KiB
+     at most), or else the hash table. */
+  Visited::Visited(std::size_t cells): Visited{}
+  {
+    if (cells <= dense_cells)
+      { bits.resize((cells + 63) / 64); }
+  }
+
+  // Inserts a cell index, returning true if it was not yet visited.
+  bool
+  Visited::insert(std::uint64_t index)
+  {
+    if (not bits.empty())
+      {
+	std::uint64_t& word = bits[index / 64];
+	const std::uint64_t bit = std::uint64_t{1} << (index % 64);
+	const bool fresh = not (word & bit);
+	word |= bit;
+	return fresh;
+      }
+
+    if (2 * (count + 1) > slots.size())
+      { grow(); }
+
+    std::uint64_t& slot = slots[find(index)];
+    if (slot == index)
+      { return false; }
+    slot = index;
+    ++count;
+    return true;
+  }
+
+  bool
+  Visited::contains(std::uint64_t index) const
+  {
+    if (not bits.empty())
+      { return (bits[index / 64] >> (index % 64)) & 1; }
+    return not slots.empty() and slots[find(index)] == index;
+  }
+
+  // Prefetches the word or first slot an index would be found in.
+  void
+  Visited::prefetch(std::uint64_t index) const
+  {
+    if (not bits.empty())
+      { __builtin_prefetch(&bits[index / 64]); }
+    else if (not slots.empty())
+      { __builtin_prefetch(&slots[home(index)]); }
+  }
+
+  // The slot an index's probe starts at: its Fibonacci hash.
+  std::size_t
+  Visited::home(std::uint64_t index) const
+  { return (index * 0x9E3779B97F4A7C15ull) >> shift; }
+
+  /* Returns the slot holding index, or else the empty slot where it
+     belongs, probing linearly from its home. */
+  std::size_t
+  Visited::find(std::uint64_t index) const
+  {
+    const std::size_t mask = slots.size() - 1;
+    std::size_t i = home(index);
+    while (slots[i] != index and slots[i] != empty_slot)
+      { i = (i + 1) & mask; }
+    return i;
+  }
+
+  // Doubles the table (starting small) and rehashes visited cells.
+  void
+  Visited::grow()
+  {
+    std::vector<std::uint64_t> old(slots.empty() ? 256 : 2 * slots.size(),
+				   empty_slot);
+    swap(old, slots);
+    shift = 64;
+    for (std::size_t n = slots.size(); n > 1; n /= 2)
+      { --shift; }
+
+    for (auto index : old)
+      if (index != empty_slot)
+	{ slots[find(index)] = index; }
+  }
+
+  Map::Map(): max_ticks{0}, ticks{0}, width{0}, height{0}, score{0}, pieces{0},
+	      position{Position{}}, trace{nullptr}, run{nullptr}, entered{nullptr} {}
+
+  // Map from a map file in either format; throws if it cannot be loaded.
+  Map::Map(const std::string& filename, int ticks):
+    Map{Tiles::load(filename), ticks} {}
+
+  // Map from a grid of cells, such as a generated trail.
+  Map::Map(std::vector<std::vector<Cell>> grid, int ticks):
+    Map{std::make_shared<const Tiles>(grid), ticks} {}
+
+  Map::Map(std::shared_ptr<const Tiles> tiles, int ticks):
+    max_ticks{ticks}, ticks{0}, width{tiles->get_width()},
+    height{tiles->get_height()}, score{0}, pieces{tiles->get_pieces()},
+    position{Position{}}, food{std::move(tiles)}, visited{width * height},
+    trace{nullptr}, run{nullptr}, entered{nullptr} {}
+
+  // This map with its own copy of the food, local to the calling thread.
+  Map
+  Map::local() const
+  {
+    Map copy{*this};
+    copy.food = food->local();
+    return copy;
   }
 
   bool
   Map::active() const
   { return ticks < max_ticks; }
 
+  /* Movement is table driven: the offsets of a step in each
+     direction and the directions a turn leads to, indexed by
+     Direction. */
+  const int step_x[] = {0, 0, 1, -1};
+  const int step_y[] = {-1, 1, 0, 0};
+  const Direction turn_left[] = {Direction::west, Direction::east,
+				 Direction::north, Direction::south};
+  const Direction turn_right[] = {Direction::east, Direction::west,
+				  Direction::south, Direction::north};
+
+  /* Wraps a coordinate at most one step outside [0, size) around the
+     torus, with comparisons instead of a division or branch. */
+  inline int
+  wrap(int v, int size)
+  { return v + size * ((v < 0) - (v >= size)); }
+
+  /* Sets x and y to the cell one step ahead of the ant (through
+     references, as returning a Position would pass through memory). */
+  inline void
+  Map::ahead(int& x, int& y) const
+  {
+    const int d = static_cast<int>(position.direction);
+    x = wrap(position.x + step_x[d], static_cast<int>(width));
+    y = wrap(position.y + step_y[d], static_cast<int>(height));
+  }
+
   bool
   Map::look() const
   {
-    Position ahead = position;
-    switch (position.direction)
-      {
-      case Direction::north:
-	{ ahead.y = (position.y - 1) % height; break; }
-      case Direction::west:
-	{ ahead.x = (position.x - 1) % width; break; }
-      case Direction::south:
-	{ ahead.y = (position.y + 1) % height; break; }
-      case Direction::east:
-	{ ahead.y = (position.x + 1) % width; break; }
-      }
-    return (rows[ahead.y][ahead.x] == Cell::food);
+    int x, y;
+    ahead(x, y);
+    return food->food(x, y) and not visited.contains(y * width + x);
+  }
+
+  /* Prefetches the food and visits of the cell ahead, so that a look
+     or forward made after other work finds them in cache. */
+  void
+  Map::prefetch() const
+  {
+    int x, y;
+    ahead(x, y);
+    food->prefetch(x, y);
+    visited.prefetch(y * width + x);
   }
 
   void
   Map::forward()
   {
-    switch (position.direction)
+    ahead(position.x, position.y);
+    // Mark location on map as visited, scoring food not yet eaten
+    const std::uint64_t cell = position.y * width + position.x;
+    if (visited.insert(cell))
       {
-      case Direction::north:
-	{ position.y = (position.y - 1) % height; break; }
-      case Direction::west:
-	{ position.x = (position.x - 1) % width; break; }
-      case Direction::south:
-	{ position.y = (position.y + 1) % height; break; }
-      case Direction::east:
-	{ position.y = (position.x + 1) % width; break; }
+	if (run)
+	  { run->cells.push_back(cell); }
+	if (food->food(position.x, position.y))
+	  {
+	    ++score;
+	    if (trace)
+	      { trace->eaten.push_back(ticks); }
+	  }
       }
-    // Increment score if moved onto food
-    if (rows[position.y][position.x] == Cell::food)
-      { ++score; }
 
-    // Mark location on map as visitied
-    rows[position.y][position.x] = Cell::marked;
+    if (trace)
+      { trace->record(Action::forward); }
 
     ++ticks;
   }
@@ -119,34 +570,18 @@ namespace options
   void
   Map::left()
   {
-    switch (position.direction)
-      {
-      case Direction::north:
-	{ position.direction = Direction::west; break; }
-      case Direction::west:
-	{ position.direction = Direction::south; break; }
-      case Direction::south:
-	{ position.direction = Direction::east; break; }
-      case Direction::east:
-	{ position.direction = Direction::north; break; }
-      }
+    position.direction = turn_left[static_cast<int>(position.direction)];
+    if (trace)
+      { trace->record(Action::left); }
     ++ticks;
   }
 
   void
   Map::right()
   {
-    switch (position.direction)
-      {
-      case Direction::north:
-	{ position.direction = Direction::east; break; }
-      case Direction::east:
-	{ position.direction = Direction::south; break; }
-      case Direction::south:
-	{ position.direction = Direction::west; break; }
-      case Direction::west:
-	{ position.direction = Direction::north; break; }
-      }
+    position.direction = turn_right[static_cast<int>(position.direction)];
+    if (trace)
+      { trace->record(Action::right); }
     ++ticks;
   }
 
@@ -162,20 +597,17 @@ namespace options
   {
     std::stringstream out;
     out << "# 'x' is food and 'o' is ant trail\n";
-    for (const auto& row : rows)
+    for (std::size_t y{0}; y < height; ++y)
       {
-	for (auto cell : row)
+	for (std::size_t x{0}; x < width; ++x)
 	  {
 	    // Add blank, food, and marked locations
-	    switch (cell)
-	      {
-	      case Cell::blank:
-		{ out << '.'; break; }
-	      case Cell::food:
-		{ out << 'x'; break; }
-	      case Cell::marked:
-		{ out << 'o'; break; }
-	      }
+	    if (visited.contains(y * width + x))
+	      { out << 'o'; }
+	    else if (food->food(x, y))
+	      { out << 'x'; }
+	    else
+	      { out << '.'; }
 	  }
 	// Add newline after each row
 	out << '\n';
@@ -183,40 +615,219 @@ namespace options
     return out.str();
   }
 
+  /* Returns a run's trace headed by its map's source, ticks and
+     score, in the format read back by the replay program. */
+  std::string
+  Map::print(const Trace& run) const
+  {
+    std::stringstream out;
+    out << "map " << food->get_source()
+	<< "\nticks " << ticks
+	<< "\nscore " << score << '\n'
+	<< run.print();
+    return out.str();
+  }
+
+  // Records this map's following actions into the given trace.
+  void
+  Map::record(Trace* run)
+  { trace = run; }
+
+  /* Checkpoints this map's following entries into the given run,
+     whose entered nodes must already be sized for the tree. */
+  void
+  Map::checkpoint(Run* into)
+  {
+    run = into;
+    entered = run ? run->entered.data() : nullptr;
+    if (run)
+      { run->cells.reserve(max_ticks); }
+  }
+
+  bool
+  Map::checkpointing() const
+  { return run != nullptr; }
+
+  // Checkpoints the first entry of a node.
+  void
+  Map::first(int node)
+  {
+    entered[node] = run->entries.size();
+    run->entries.push_back({node, position, ticks, score, run->cells.size()});
+  }
+
+  /* Restores the state at the given entry of an earlier run
+     (replaying its visited cells), continuing that run's cells. */
+  void
+  Map::resume(const Run& from, std::size_t entry)
+  {
+    assert(not trace); // Eaten ticks before the checkpoint are unknown.
+    const Run::Entry& e = from.entries[entry];
+    position = e.position;
+    ticks = e.ticks;
+    score = e.score;
+    for (std::size_t i{0}; i < e.cells; ++i)
+      { visited.insert(from.cells[i]); }
+
+    if (run)
+      { run->cells.assign(begin(from.cells), begin(from.cells) + e.cells); }
+  }
+
+  constexpr int Run::never;
+
+  /* Returns the last entry at or before the given one at which a run
+     with the given tick limit would still be active. */
+  std::size_t
+  Run::resumable(int entry, int limit) const
+  {
+    std::size_t e = std::min<std::size_t>(entry, entries.size() - 1);
+    while (e > 0 and entries[e].ticks >= limit)
+      { --e; }
+    return e;
+  }
+
+  int
+  Map::get_ticks() const
+  { return ticks; }
+
+  bool
+  Map::tracing() const
+  { return trace != nullptr; }
+
+  Map::Layout
+  Map::layout()
+  {
+    const Map map;
+    const char* base = reinterpret_cast<const char*>(&map);
+    auto offset = [base](const void* member)
+      { return static_cast<const char*>(member) - base; };
+    return Layout{offset(&map.ticks), offset(&map.max_ticks),
+		  offset(&map.position.direction)};
+  }
+
+  // Bytes of food storage, shared by all copies of this map.
+  std::size_t
+  Map::memory() const
+  { return food ? food->memory() : 0; }
+
+  std::size_t
+  Samples::size() const
+  { return x.size(); }
+
+  bool
+  Samples::empty() const
+  { return x.empty(); }
+
+  /* Reads the samples of a regression dataset, x and y separated by
+     whitespace per line (blank lines skipped), streaming each line
+     into the columns, so only the columns are ever held.  Throws
+     std::runtime_error if unreadable or a line is not two numbers. */
+  Samples
+  read_samples(const std::string& filename)
+  {
+    std::ifstream file{filename};
+    if (not file)
+      { throw std::runtime_error{"File " + filename + " could not be read!"}; }
+
+    Samples samples;
+    std::string line;
+    while (std::getline(file, line))
+      {
+	const char* begin = line.c_str();
+	char* end;
+	const double x = std::strtod(begin, &end);
+	if (end == begin)
+	  {
+	    if (line.find_first_not_of(" \t\r") == std::string::npos)
+	      { continue; }
+	    throw std::runtime_error{"File " + filename + " had a bad sample!"};
+	  }
+	begin = end;
+	const double y = std::strtod(begin, &end);
+	if (end == begin or std::strspn(end, " \t\r") != std::strlen(end))
+	  { throw std::runtime_error{"File " + filename + " had a bad sample!"}; }
+	samples.x.push_back(x);
+	samples.y.push_back(y);
+      }
+    if (samples.empty())
+      { throw std::runtime_error{"File " + filename + " had no samples!"}; }
+    samples.x.shrink_to_fit();
+    samples.y.shrink_to_fit();
+    return samples;
+  }
+
   // Validates options parameters; should instead be unit tests.
   void
   Options::validate() const
   {
     assert(trials > 0);
     assert(generations > 0);
+    assert(target >= 0);
+    assert(stagnation >= 0);
+    assert(evaluations >= 0);
+    assert(trial_time >= 0 and trial_cpu >= 0);
+    assert(run_time >= 0 and run_cpu >= 0);
     assert(pop_size > 0);
+    assert(problem == "ant" or problem == "regression");
+    assert(problem != "ant" or not maps.empty());
+    assert(problem != "regression" or (samples and not samples->empty()));
+    assert(error == "mae" or error == "rmse");
+    assert(log_format == "text" or log_format == "binary");
     assert(min_depth >= 0);
     assert(max_depth >= min_depth);
     assert(depth_limit >= max_depth);
+    assert(memory_limit >= 0);
     assert(tourney_size > 0 and tourney_size <= pop_size);
     assert(fit_size > 0 and fit_size <= pop_size);
     assert(brood_count >= 0);
     assert(crossover_size == 2 or crossover_size == 0);
     assert(elitism_size >= 0 and elitism_size <= pop_size);
+    assert(parallel_size >= 0);
+    assert(jit_threshold >= 0);
+    assert(jit_threshold == 0 or not resume);
+    assert(interleave >= 0);
     assert(penalty >= 0 and penalty <= 1);
     assert(grow_chance >= 0 and grow_chance <= 1);
     assert(over_select_chance >= 0 and over_select_chance <= 1);
     assert(mutate_chance >= 0 and mutate_chance <= 1);
     assert(crossover_chance >= 0 and crossover_chance <= 1);
     assert(internals_chance >= 0 and internals_chance <= 1);
+    assert(surrogate >= 0 and surrogate <= 1);
+    assert(surrogate_sample >= 0 and surrogate_sample <= 1);
+  }
+
+  /* These options with their own copies of the maps and samples, made
+     by (so local to the node of) the calling thread. */
+  Options
+  Options::local() const
+  {
+    Options copy{*this};
+    for (auto& map : copy.maps)
+      { map = map.local(); }
+    if (samples)
+      { copy.samples = std::make_shared<const Samples>(*samples); }
+    return copy;
   }
 
   /* Given main's argc and argv, this will parse command-line options
      and the optional config file to return a built-up Options struct
-     with all values, default or explicitly set. */
+     with all values, default or explicitly set.  Overrides are stored
+     first, so take precedence (as the command line does over the
+     config file).  With shared options (as for each parameter set of
+     a sweep), their maps or samples are shared rather than read.
+     Throws std::exception for bad options or data. */
   const Options
-  parse(int argc, char* argv[])
+  configure(int argc, char* argv[], const std::vector<std::string>& overrides,
+	    const Options* shared)
   {
     using std::string;
     using namespace boost::program_options;
 
-    string filename;
+    std::vector<string> filenames;
+    string data;
     int ticks;
+    int generate;
+    generator::Parameters trail;
     Options options;
 
     positional_options_description positionals;
@@ -231,9 +842,27 @@ namespace options
        default_value("search.cfg"),
        "specify the configuration file")
 
-      ("file,f", value<string>(&filename)->
-       default_value("test/santa-fe-trail.dat"),
-       "specify the location of the columnized test data \"X Y\"")
+      ("problem", value<string>(&options.problem)->
+       default_value("ant"),
+       "set the problem: ant (on the maps of file) or regression (on the samples of data)")
+
+      ("data", value<string>(&data)->
+       default_value("test/cs472.dat"),
+       "specify the regression samples, x and y per line")
+
+      ("error", value<string>(&options.error)->
+       default_value("mae"),
+       "set the regression fitness: mae (mean absolute error) or rmse (root mean squared error)")
+
+      ("sweep", value<string>(&options.sweep)->
+       default_value(""),
+       "run each parameter set of this file (name=value,... per line, gridded) on one pool")
+
+      ("file,f", value<std::vector<string>>(&filenames)->
+       multitoken()->composing()->
+       default_value(std::vector<string>{"test/santa-fe-trail.dat"},
+		     "test/santa-fe-trail.dat"),
+       "specify the map(s) of the training set; repeat for multiple maps")
 
       ("trials,t", value<int>(&options.trials)->
        default_value(4),
@@ -244,6 +873,34 @@ namespace options
        default_value(128),
        "set the number of iterations for which to run each trial")
 
+      ("target", value<int>(&options.target)->
+       default_value(0),
+       "stop a trial reaching this score, cancelling the others (0 to disable)")
+
+      ("stagnation", value<int>(&options.stagnation)->
+       default_value(0),
+       "stop a trial after this many generations without a fitter best (0 to disable)")
+
+      ("evaluations", value<long>(&options.evaluations)->
+       default_value(0),
+       "stop a trial after this many evaluations (0 to disable)")
+
+      ("trial-time", value<double>(&options.trial_time)->
+       default_value(0),
+       "stop a trial after this many seconds (0 to disable)")
+
+      ("trial-cpu", value<double>(&options.trial_cpu)->
+       default_value(0),
+       "stop a trial after this many seconds of its thread's CPU time (0 to disable)")
+
+      ("run-time", value<double>(&options.run_time)->
+       default_value(0),
+       "stop all trials after this many seconds (0 to disable)")
+
+      ("run-cpu", value<double>(&options.run_cpu)->
+       default_value(0),
+       "stop all trials after this many seconds of the process's CPU time (0 to disable)")
+
       ("population,p",
        value<int>(&options.pop_size)->
        default_value(1024),
@@ -259,7 +916,11 @@ namespace options
 
       ("depth-limit,l", value<int>(&options.depth_limit)->
        default_value(14),
-       "set the depth limit for individuals")
+       "set the depth limit for individuals, after any genetic operator")
+
+      ("memory-limit", value<double>(&options.memory_limit)->
+       default_value(0),
+       "set the megabytes of tree nodes all trials may hold, tightening depth and size limits near it (0 for none)")
 
       ("tournament-size,T",
        value<int>(&options.tourney_size)->
@@ -285,6 +946,34 @@ namespace options
        default_value(3),
        "set the number of elitism replacements to make each iteration")
 
+      ("generate", value<int>(&generate)->
+       default_value(0),
+       "add the given number of generated trails to the training set")
+
+      ("racing,R", bool_switch(&options.racing),
+       "stop evaluating an individual on the remaining maps once it cannot beat the selection threshold")
+
+      ("profile", bool_switch(&options.profile),
+       "count cycles, instructions, cache and branch misses of variation and evaluation with perf_event_open, logged per trial")
+
+      ("pin", bool_switch(&options.pin),
+       "pin each trial's thread to its own core (read from sysfs), with its own copy of the data on its node")
+
+      ("resume", bool_switch(&options.resume),
+       "resume evaluations of changed copies from checkpoints of their parent's runs (not with --jit)")
+
+      ("parallel-size", value<int>(&options.parallel_size)->
+       default_value(0),
+       "set the tree size at which maps are evaluated in parallel (0 to disable)")
+
+      ("jit", value<int>(&options.jit_threshold)->
+       default_value(0),
+       "compile individuals to native code once evaluated this many times (0 to disable; not with --resume, whose checkpoints need the interpreter)")
+
+      ("interleave", value<int>(&options.interleave)->
+       default_value(0),
+       "evaluate children in batches, interleaving this many ants' runs, each prefetching the cell ahead before yielding to the next (0 to evaluate one at a time)")
+
       ("ticks", value<int>(&ticks)->
        default_value(600),
        "set the number of moves the ant may move")
@@ -313,6 +1002,14 @@ namespace options
        default_value(0.9),
        "set the probability that a crossover target node will be an internal node")
 
+      ("surrogate", value<float>(&options.surrogate)->
+       default_value(0),
+       "evaluate only this fraction of children and brood pups, those a linear model of fitness over their features ranks highest, once fit (0 to evaluate all)")
+
+      ("surrogate-sample", value<float>(&options.surrogate_sample)->
+       default_value(0.05),
+       "set the probability that a screened child is evaluated whatever its rank, to train the surrogate and measure its accuracy")
+
       ("logs", value<string>(&options.logs_dir)->
        default_value("logs/"),
        "set the save directory for log files")
@@ -321,44 +1018,129 @@ namespace options
        default_value("plots/"),
        "set the save directory for plot data files")
 
+      ("log-format", value<string>(&options.log_format)->
+       default_value("text"),
+       "set the format of log files: text, or binary (.bin, exported to text by dump)")
+
+      ("telemetry", value<string>(&options.telemetry)->
+       default_value(""),
+       "set a file (say /dev/shm/antgp) to publish live trial statistics to, shown by observe")
+
       ("verbosity,v", value<int>(&options.verbosity)->
        default_value(1),
        "set the verbosity: 0 - no logging; 1 - normal logging; 2 - debug output");
 
-    /* Stores CLI and config file options. Will catch exception and
-       exit with EXIT_FAILURE if given bad input. */
-    try
-      {
-	store(parse_command_line(argc, argv, description), variables_map);
-
-	std::ifstream config{variables_map["config"].as<string>()};
-	if (config)
-	  { store(parse_config_file(config, description), variables_map); }
+    description.add(generator::description(trail));
 
-	notify(variables_map);
-      }
-    catch (const std::exception& e)
+    /* Stores override, CLI and config file options.  Maps compose
+       within one source (for repeated -f), so a later source's are
+       dropped once an earlier one has given any. */
+    auto layer = [&variables_map](parsed_options parsed)
       {
-	std::cerr << e.what() << std::endl;
-	std::exit(EXIT_FAILURE);
+	if (variables_map.count("file") and not variables_map["file"].defaulted())
+	  parsed.options.erase(std::remove_if(begin(parsed.options), end(parsed.options),
+					      [](const basic_option<char>& o)
+					      { return o.string_key == "file"; }),
+			       end(parsed.options));
+	store(parsed, variables_map);
+      };
+    if (not overrides.empty())
+      {
+	// Separately, as "--config=" (for none) would be a syntax error.
+	std::vector<string> arguments;
+	for (const auto& o : overrides)
+	  {
+	    const std::size_t equals = o.find('=');
+	    arguments.push_back("--" + o.substr(0, equals));
+	    if (equals != string::npos)
+	      { arguments.push_back(o.substr(equals + 1)); }
+	  }
+	layer(command_line_parser(arguments).options(description).run());
       }
 
+    layer(parse_command_line(argc, argv, description));
+
+    std::ifstream config{variables_map["config"].as<string>()};
+    if (config)
+      { layer(parse_config_file(config, description)); }
+
+    notify(variables_map);
+
     // Print options help and exit with EXIT_SUCCESS when finished.
     if (variables_map.count("help"))
       {
 	std::cout << "Genetic Program implemented in C++ by Andrew Schwartzmeyer\n"
 		  << "Code located at https://github.com/andschwa/uidaho-cs472-project3\n\n"
 		  << "Logs saved to <" << options.logs_dir << ">/<Unix time>.dat\n"
-		  << "Ant maps saved to <" << options.plots_dir << ">/<Unix time>.dat\n"
+		  << "Binary logs saved to <" << options.logs_dir << ">/<Unix time>.bin, exported by antgp-dump\n"
+		  << "Ant traces saved to <" << options.plots_dir << ">/<Unix time>.trace\n"
+		  << "Regression fits saved to <" << options.plots_dir << ">/<Unix time>.fit\n"
+		  << "Sweep results saved to <" << options.logs_dir << ">/<Unix time>_0.csv\n"
+		  << "Ant maps rebuilt from traces by antgp-replay\n"
 		  << "GNUPlot PNG generation scripts in <tools>'\n\n"
 		  << description << std::endl;
 	std::exit(EXIT_SUCCESS);
       }
 
-    // get values from given test file
-    options.map = Map(filename, ticks);
+    if (options.problem != "ant" and options.problem != "regression")
+      { throw std::runtime_error{"Unknown problem " + options.problem + "!"}; }
+
+    if (options.error != "mae" and options.error != "rmse")
+      { throw std::runtime_error{"Unknown error " + options.error + "!"}; }
+
+    if (options.log_format != "text" and options.log_format != "binary")
+      {
+	throw std::runtime_error{"Unknown log format " + options.log_format
+	    + "!"};
+      }
+
+    // checkpointed runs are interpreted, so compiled code would never run
+    if (options.jit_threshold > 0 and options.resume)
+      { throw std::runtime_error{"Options jit and resume cannot be combined!"}; }
+
+    // share the maps and samples of a sweep, with these options' ticks
+    if (shared)
+      {
+	options.maps = shared->maps;
+	for (auto& map : options.maps)
+	  { map.max_ticks = ticks; }
+	options.samples = shared->samples;
+	options.validate();
+	return options;
+      }
+
+    // generated trails replace the default map
+    if (generate > 0 and variables_map["file"].defaulted())
+      { filenames.clear(); }
+
+    // get values from given map (or sample) files
+    if (options.problem == "regression")
+      { options.samples = std::make_shared<const Samples>(read_samples(data)); }
+    else
+      for (const auto& filename : filenames)
+	{ options.maps.emplace_back(filename, ticks); }
+
+    // generate trails with successive seeds
+    if (options.problem == "ant")
+      for (int i{0}; i < generate; ++i, ++trail.seed)
+	{ options.maps.push_back(generator::map(trail, ticks)); }
     options.validate();
 
     return options;
   }
+
+  /* As configure, but for main: bad options or data are printed, and
+     exit with EXIT_FAILURE. */
+  const Options
+  parse(int argc, char* argv[], const std::vector<std::string>& overrides,
+	const Options* shared)
+  {
+    try
+      { return configure(argc, argv, overrides, shared); }
+    catch (const std::exception& e)
+      {
+	std::cerr << e.what() << std::endl;
+	std::exit(EXIT_FAILURE);
+      }
+  }
 }
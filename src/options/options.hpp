@@ -8,6 +8,11 @@
 #ifndef _OPTIONS_H_
 #define _OPTIONS_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -26,22 +31,155 @@ namespace options
     Position();
   };
 
-  // toroidal map as vector of vector of bools
+  /* A read-only mapping of a file, unmapped when the last owner lets
+     go; throws std::runtime_error if the file cannot be mapped. */
+  class Mapping
+  {
+  public:
+    Mapping(const std::string&);
+    ~Mapping();
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    const char* data;
+    std::size_t size;
+  };
+
+  /* Food of a map bit-packed in 64 by 64 tiles.  A directory maps
+     each tile to its bits, and every tile without food shares one
+     empty tile, so memory scales with the food rather than the area.
+     Immutable once built, so copies of a map share one instance.
+     Tiles are built in memory, parsed in one pass from a mapped text
+     map file, or mapped zero-copy from a binary map file (see save). */
+  class Tiles
+  {
+  public:
+    Tiles(const std::vector<std::vector<Cell>>&);
+    Tiles(const std::vector<std::vector<bool>>&,
+	  const std::string& = "generated");
+    static std::shared_ptr<const Tiles> load(const std::string&);
+    std::shared_ptr<const Tiles> local() const;
+    void save(std::ostream&) const;
+    void print(std::ostream&) const;
+    bool food(std::size_t, std::size_t) const;
+    void prefetch(std::size_t, std::size_t) const;
+    std::size_t get_width() const;
+    std::size_t get_height() const;
+    int get_pieces() const;
+    const std::string& get_source() const;
+    std::size_t memory() const;
+
+  private:
+    Tiles();
+    std::string source;
+    std::size_t width;
+    std::size_t height;
+    std::size_t columns;
+    std::size_t tiles;
+    int pieces;
+    const std::uint32_t* directory;
+    const std::uint64_t* words;
+    std::shared_ptr<const void> storage;
+    template<typename B> void adopt(B&&);
+  };
+
+  /* Set of visited cell indices: a bitset of the map's cells for
+     small maps, else an open-addressed hash table which grows with
+     the ticks of one evaluation (not the map). */
+  class Visited
+  {
+  public:
+    Visited();
+    Visited(std::size_t);
+    bool insert(std::uint64_t);
+    bool contains(std::uint64_t) const;
+    void prefetch(std::uint64_t) const;
+
+  private:
+    std::vector<std::uint64_t> bits;
+    std::vector<std::uint64_t> slots;
+    std::size_t count;
+    unsigned int shift;
+    std::size_t home(std::uint64_t) const;
+    std::size_t find(std::uint64_t) const;
+    void grow();
+  };
+
+  enum class Action : char { forward = 'F', left = 'L', right = 'R' };
+
+  /* Record of an ant's run: its run-length encoded actions and the
+     ticks at which it ate food.  Replaying the actions on the same map
+     rebuilds the run in time proportional to its ticks. */
+  struct Trace
+  {
+    std::vector<std::pair<Action, int>> actions;
+    std::vector<int> eaten;
+    void record(Action);
+    std::string print() const;
+  };
+
+  /* Checkpoints of an ant's run, from which a changed copy of its
+     program resumes: the map's state at the first entry of each node
+     (numbered in preorder), in order of entry, and the cells in the
+     order first visited.  Until a changed node is entered, the copy
+     runs as the original. */
+  struct Run
+  {
+    struct Entry
+    {
+      int node;
+      Position position;
+      int ticks;
+      int score;
+      std::size_t cells;
+    };
+    static constexpr int never = std::numeric_limits<int>::max();
+    std::vector<Entry> entries;
+    std::vector<int> entered; // Index of each node's entry, or never.
+    std::vector<std::uint64_t> cells;
+    int score;
+    int max_ticks;
+    std::size_t resumable(int, int) const;
+  };
+
+  // toroidal map of shared food tiles and per-evaluation visited cells
   class Map
   {
   public:
     Map();
     Map(const std::string&, int);
+    Map(std::vector<std::vector<Cell>>, int);
+    Map(std::shared_ptr<const Tiles>, int);
+    Map local() const;
     bool active() const;
     bool look() const;
+    void prefetch() const;
     void forward();
     void left();
     void right();
     int fitness() const;
     int max() const;
     std::string print() const;
+    std::string print(const Trace&) const;
+    void record(Trace*);
+    std::size_t memory() const;
+    bool tracing() const;
+    void checkpoint(Run*);
+    bool checkpointing() const;
+    void resume(const Run&, std::size_t);
+    void enter(int);
+    int get_ticks() const;
     int max_ticks;
 
+    // Byte offsets of the tick and direction state, for compiled programs.
+    struct Layout
+    {
+      std::ptrdiff_t ticks;
+      std::ptrdiff_t max_ticks;
+      std::ptrdiff_t direction;
+    };
+    static Layout layout();
+
   private:
     int ticks;
     std::size_t width;
@@ -49,39 +187,99 @@ namespace options
     int score;
     int pieces;
     Position position;
-    std::vector<std::vector<Cell>> rows;
+    std::shared_ptr<const Tiles> food;
+    Visited visited;
+    Trace* trace;
+    Run* run;
+    int* entered; // Of run, sized before checkpointing starts.
+    void ahead(int&, int&) const;
+    void first(int);
   };
 
+  // Records a node's first entry, if checkpointing (inline as it is hot).
+  inline void
+  Map::enter(int node)
+  {
+    if (entered and entered[node] == Run::never)
+      { first(node); }
+  }
+
+  /* The samples of a regression dataset, y as observed at x, stored
+     as columns so evaluation streams through each. */
+  struct Samples
+  {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::size_t size() const;
+    bool empty() const;
+  };
+
+  Samples read_samples(const std::string&);
+
   // "singleton" struct with configured options for the algorithm
   // setup and returned by parse()
   struct Options
   {
-    Map map;
+    std::string problem;
+    std::string error;
+    std::string sweep;
+    std::vector<Map> maps;
+    std::shared_ptr<const Samples> samples; // Shared by swept options.
     int trials;
     int generations;
+    int target;
+    int stagnation;
+    long evaluations;
+    double trial_time;
+    double trial_cpu;
+    double run_time;
+    double run_cpu;
     int pop_size;
     int min_depth;
     int max_depth;
     int depth_limit;
+    double memory_limit;
     int tourney_size;
     int fit_size;
     int brood_count;
     int crossover_size;
     int elitism_size;
+    int parallel_size;
+    int jit_threshold;
+    int interleave;
+    bool racing;
+    bool resume;
+    bool profile;
     float penalty;
     float grow_chance;
     float over_select_chance;
     float mutate_chance;
     float crossover_chance;
     float internals_chance;
+    float surrogate;
+    float surrogate_sample;
     std::string logs_dir;
     std::string plots_dir;
+    std::string log_format;
+    std::string telemetry;
     int verbosity;
+    bool pin;
     void validate() const;
+    Options local() const;
   };
 
-  // given argc and argv, returns a finished and validated Options object
-  const Options parse(int argc, char* argv[]);
+  /* given argc and argv, returns a finished and validated Options
+     object; overrides ("name=value") take precedence, and if given
+     shared options, their maps or samples are shared instead of read;
+     throws std::exception for bad options or data */
+  const Options configure(int argc, char* argv[],
+			  const std::vector<std::string>& overrides = {},
+			  const Options* shared = nullptr);
+
+  // as configure, but exits with the error instead of throwing
+  const Options parse(int argc, char* argv[],
+		      const std::vector<std::string>& overrides = {},
+		      const Options* shared = nullptr);
 }
 
 #endif /* _OPTIONS_H_ */
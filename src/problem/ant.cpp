@@ -0,0 +1,535 @@
+/* ant.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for the artificial ant problem
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ant.hpp"
+#include "../jit/jit.hpp"
+#include "../metrics/metrics.hpp"
+#include "../options/options.hpp"
+
+namespace problem
+{
+  using std::vector;
+
+  Ant::State::State(): evaluations{0} {}
+
+  // The ant is trained on the maps.
+  const Ant::Cases&
+  Ant::cases(const options::Options& opts)
+  { return opts.maps; }
+
+  /* Broods are evaluated with fewer ticks: minimum plus [0, 1] * max
+     where 0 is the first generation and 1 is the final generation
+     (thus scaling the evaluation with the run's age). */
+  Ant::Cases
+  Ant::brood(const Cases& maps, float scale)
+  {
+    Cases scaled = maps;
+    for (auto& map : scaled)
+      {
+	int min = 0.1 * map.max_ticks;
+	map.max_ticks = min + scale * (map.max_ticks - min);
+      }
+    return scaled;
+  }
+
+  // Traces of the ant, from which the replay program rebuilds maps.
+  const char* const Ant::extension = ".trace";
+
+  /* Run ant across map until out of ticks and return its score, with
+     compiled code if available (and not tracing or checkpointing).
+     Given a path, the first pass resumes from the node at its end. */
+  int
+  Ant::run(const Individual& individual, options::Map& map,
+	   const vector<unsigned int>* path)
+  {
+    const auto& compiled = individual.state.compiled;
+    if (compiled and not map.tracing() and not map.checkpointing())
+      { compiled->run(map); }
+    else
+      {
+	if (path)
+	  { resume(individual.root, *path, 0, map); }
+	while (map.active())
+	  { individual.root.evaluate(map); }
+      }
+    METRICS_COUNT(evaluations, 1);
+    METRICS_COUNT(ticks, map.get_ticks());
+    return map.fitness();
+  }
+
+  // State of a preorder numbering of the tree for fresh runs.
+  struct Ant::Numbering
+  {
+    vector<std::shared_ptr<options::Run>>& fresh;
+    const vector<std::size_t>& from;
+    vector<vector<unsigned int>>& paths;
+    vector<int> targets;
+    vector<unsigned int> path;
+    int next;
+  };
+
+  /* Number the tree in preorder for the fresh runs.  Each inherits
+     its parent's entries before the one it resumes from (identical in
+     this run, and all of unchanged nodes), and finds the path to the
+     node of that entry. */
+  void
+  Ant::renumber(Individual& individual,
+		vector<std::shared_ptr<options::Run>>& fresh,
+		const vector<std::size_t>& from,
+		vector<vector<unsigned int>>& paths)
+  {
+    const auto& runs = individual.state.runs;
+    Numbering numbering{fresh, from, paths, vector<int>(fresh.size(), -1), {}, 0};
+    for (std::size_t i{0}; i < fresh.size(); ++i)
+      if (fresh[i])
+	{
+	  fresh[i]->entered.assign(individual.get_total(), options::Run::never);
+	  fresh[i]->entries.reserve(individual.get_total());
+	  if (i < runs.size() and runs[i] and not runs[i]->entries.empty())
+	    {
+	      fresh[i]->entries.resize(from[i]);
+	      numbering.targets[i] = runs[i]->entries[from[i]].node;
+	    }
+	}
+    number(individual, individual.root, numbering);
+  }
+
+  void
+  Ant::number(const Individual& individual, Node& node, Numbering& n)
+  {
+    const auto& runs = individual.state.runs;
+    if (node.id >= 0)
+      for (std::size_t i{0}; i < n.fresh.size(); ++i)
+	if (n.targets[i] >= 0)
+	  {
+	    if (node.id == n.targets[i])
+	      { n.paths[i] = n.path; }
+	    const int entry = runs[i]->entered[node.id];
+	    if (entry < static_cast<int>(n.from[i]))
+	      {
+		n.fresh[i]->entered[n.next] = entry;
+		n.fresh[i]->entries[entry] = runs[i]->entries[entry];
+		n.fresh[i]->entries[entry].node = n.next;
+	      }
+	  }
+    node.id = n.next++;
+    for (unsigned int c{0}; c < node.children.size(); ++c)
+      {
+	n.path.push_back(c);
+	number(individual, node.children[c], n);
+	n.path.pop_back();
+      }
+  }
+
+  /* Unnumber a subtree that changed since its run was checkpointed,
+     except for its root, which takes the number of the node it
+     replaced so that the changed position can be found. */
+  void
+  Ant::forget(Node& node, int replaced)
+  {
+    node.id = replaced;
+    for (auto& child : node.children)
+      { forget(child, -1); }
+  }
+
+  /* Continue a pass from the first entry of the node at the given
+     path, the nodes along it having been entered already: the rest
+     of each sequence follows, whereas a conditional took its branch. */
+  void
+  Ant::resume(const Node& node, const vector<unsigned int>& path,
+	      std::size_t depth, options::Map& map)
+  {
+    if (depth == path.size())
+      {
+	node.evaluate(map);
+	return;
+      }
+    const unsigned int k = path[depth];
+    resume(node.children[k], path, depth + 1, map);
+    if (not Primitives::conditional(node.function))
+      for (unsigned int j = k + 1; j < node.children.size(); ++j)
+	{ node.children[j].evaluate(map); }
+  }
+
+  /* One ant's run of a batch: its individual, the map it is on (a
+     copy of the next to run), and the nodes it has yet to evaluate as
+     a stack, so that the run can stop at any node and later continue:
+     a sequence pushes its children, last first, and a conditional its
+     branch. */
+  struct Ant::Lane
+  {
+    Individual* individual{nullptr};
+    std::size_t index{0}; // Of the map.
+    options::Map map;
+    vector<const Node*> stack;
+    const Node* waiting{nullptr}; // To look or move, its cell prefetched.
+    int score{0};
+    int remaining{0}; // Food on the maps after this one.
+    long nodes{0};
+  };
+
+  /* Continues the lane's run, evaluating nodes as Node::evaluate
+     does, until one is to look at or move to the cell ahead: that cell
+     is prefetched and true returned, to act on it when next stepped.
+     Returns false once the ant is out of ticks. */
+  bool
+  Ant::step(Lane& lane)
+  {
+    options::Map& map = lane.map;
+    auto& stack = lane.stack;
+    if (lane.waiting)
+      {
+	const Node& node = *lane.waiting;
+	lane.waiting = nullptr;
+	if (node.function == Function::forward)
+	  { map.forward(); }
+	else
+	  { stack.push_back(&node.children[map.look() ? 0 : 1]); }
+      }
+
+    while (true)
+      {
+	// Out of ticks, every node left would return at once.
+	if (not map.active())
+	  {
+	    stack.clear();
+	    return false;
+	  }
+	if (stack.empty())
+	  { stack.push_back(&lane.individual->root); }
+	const Node& node = *stack.back();
+	stack.pop_back();
+	++lane.nodes;
+
+	switch (node.function)
+	  {
+	  case Function::left:
+	    map.left();
+	    break;
+	  case Function::right:
+	    map.right();
+	    break;
+	  case Function::forward: // Falls through
+	  case Function::iffoodahead:
+	    map.prefetch();
+	    lane.waiting = &node;
+	    return true;
+	  case Function::prog2: // Falls through
+	  case Function::prog3:
+	    for (auto child = node.children.rbegin();
+		 child != node.children.rend(); ++child)
+	      { stack.push_back(&*child); }
+	    break;
+	  case Function::nil:
+	    assert(false); // Never evaluate empty node
+	  }
+      }
+  }
+
+  /* Evaluates the individuals as Individual::evaluate would, but with
+     up to --interleave runs in flight: each lane is stepped in turn
+     until its ant is to look at or move to the cell ahead, which it
+     prefetches, so that the cache misses of different ants' cells
+     overlap rather than stall one after another.  Each lane runs its
+     individual over the maps in order (racing as usual), then takes
+     the next.  Individuals that resume, are compiled, or evaluate
+     maps in parallel are evaluated alone. */
+  void
+  Ant::evaluate(const vector<Individual*>& batch, const Cases& maps,
+		const options::Options& opts, float threshold)
+  {
+    auto alone = [&](const Individual& i)
+      {
+	return opts.interleave == 0 or opts.resume or i.state.compiled
+	  or (opts.jit_threshold > 0
+	      and i.state.evaluations + 1 == opts.jit_threshold)
+	  or (opts.parallel_size > 0 and i.get_total() >= opts.parallel_size
+	      and maps.size() > 1);
+      };
+    vector<Individual*> queue;
+    queue.reserve(batch.size());
+    for (auto individual : batch)
+      if (alone(*individual))
+	{ individual->evaluate(maps, opts, threshold); }
+      else
+	{ queue.push_back(individual); }
+
+    int total{0}; // Food available across the training set.
+    for (const auto& map : maps)
+      { total += map.max(); }
+
+    /* Starts the lane's next map, unless it has run them all or even
+       eating all remaining food cannot beat the threshold. */
+    auto next_map = [&](Lane& lane)
+      {
+	const float cost = opts.penalty * lane.individual->get_total();
+	if (lane.index == maps.size()
+	    or lane.score + lane.remaining - cost < threshold)
+	  { return false; }
+	lane.remaining -= maps[lane.index].max();
+	lane.map = maps[lane.index];
+	return true;
+      };
+
+    // Scores the lane's individual as its runs so far.
+    auto finish = [&](Lane& lane)
+      {
+	Individual& i = *lane.individual;
+	i.state.runs.clear();
+	i.state.resume.clear();
+	i.score = lane.score;
+	i.adjusted = static_cast<float>(lane.score) / total;
+	i.fitness = lane.score - opts.penalty * i.get_total();
+	lane.individual = nullptr;
+      };
+
+    // Starts the next individual on the lane, if any are left.
+    std::size_t next{0};
+    auto next_individual = [&](Lane& lane)
+      {
+	while (next < queue.size())
+	  {
+	    lane.individual = queue[next++];
+	    ++lane.individual->state.evaluations;
+	    lane.index = 0;
+	    lane.score = 0;
+	    lane.remaining = total;
+	    if (next_map(lane))
+	      { return true; }
+	    finish(lane); // Raced out before its first map.
+	  }
+	return false;
+      };
+
+    vector<Lane> lanes(std::min<std::size_t>(opts.interleave, queue.size()));
+    std::size_t running{0};
+    for (auto& lane : lanes)
+      if (next_individual(lane))
+	{ ++running; }
+
+    // Step each lane in turn until every individual is evaluated.
+    while (running > 0)
+      for (auto& lane : lanes)
+	{
+	  if (not lane.individual or step(lane))
+	    { continue; }
+	  METRICS_COUNT(evaluations, 1);
+	  METRICS_COUNT(ticks, lane.map.get_ticks());
+	  METRICS_COUNT(nodes, lane.nodes);
+	  lane.nodes = 0;
+	  lane.score += lane.map.fitness();
+	  ++lane.index;
+	  if (next_map(lane))
+	    { continue; }
+	  finish(lane);
+	  if (not next_individual(lane))
+	    { --running; }
+	}
+  }
+}
+
+namespace individual
+{
+  using std::vector;
+  using problem::Ant;
+
+  /* Evaluates an ant over a given map using a depth-first post-order
+     recursive continuous evaluation of a decision tree, dispatching
+     to each primitive's action. */
+  template<> void
+  Node<Ant>::evaluate(options::Map& map) const
+  {
+    if (not map.active()) return;
+
+    METRICS_COUNT(nodes, 1);
+    assert(function != Function::nil); // Never evaluate empty node
+    map.enter(id);
+    Ant::Primitives::evaluate(*this, map);
+  }
+
+  /* Evaluate Individual across every map of a training set, using
+     the summed score as aggregate fitness.  When racing (a finite
+     threshold), evaluation stops once the score so far plus all the
+     food on the remaining maps cannot reach the threshold; the
+     partial score is then kept, and is provably below it.  Trees of
+     at least the parallel size evaluate each map in its own thread
+     instead (without racing), as their runs dominate the cost.  Trees
+     evaluated as often as the JIT threshold are compiled, so that
+     long-lived individuals (and their copies) run natively.  When
+     resuming, each map's run is checkpointed: an unchanged copy
+     reuses its score, and a changed one resumes from the last
+     checkpoint before it first entered a changed node. */
+  template<> void
+  Individual<Ant>::evaluate(const Ant::Cases& maps,
+			    const options::Options& opts, float threshold)
+  {
+    auto& runs = state.runs;
+    auto& resume = state.resume;
+
+    ++state.evaluations;
+    if (opts.jit_threshold > 0 and state.evaluations == opts.jit_threshold)
+      { state.compiled = jit::compile(root); }
+
+    int total{0}; // Food available across the training set.
+    for (const auto& map : maps)
+      { total += map.max(); }
+    const float cost = opts.penalty * get_total();
+
+    // Runs of the previous evaluation to reuse or resume from.
+    auto parent = [&runs](std::size_t i)
+      {
+	return i < runs.size() and runs[i] and not runs[i]->entries.empty()
+	  ? runs[i].get() : nullptr;
+      };
+    auto unchanged = [&](std::size_t i)
+      {
+	return parent(i) and resume.empty()
+	  and runs[i]->max_ticks == maps[i].max_ticks;
+      };
+
+    /* Checkpoint the other maps, each resuming from the entry of the
+       node at its path (numbering the tree for them). */
+    vector<std::shared_ptr<const options::Run>> next;
+    vector<std::shared_ptr<options::Run>> fresh;
+    vector<std::size_t> from;
+    vector<vector<unsigned int>> paths;
+    if (opts.resume)
+      {
+	next.resize(maps.size());
+	fresh.resize(maps.size());
+	from.assign(maps.size(), 0);
+	paths.resize(maps.size());
+	bool numbering{false};
+	for (std::size_t i{0}; i < maps.size(); ++i)
+	  if (not unchanged(i))
+	    {
+	      fresh[i] = std::make_shared<options::Run>();
+	      if (parent(i))
+		from[i] = runs[i]->resumable(resume.empty()
+					     ? options::Run::never : resume[i],
+					     maps[i].max_ticks);
+	      numbering = true;
+	    }
+	if (numbering)
+	  { Ant::renumber(*this, fresh, from, paths); }
+      }
+
+    auto play = [&](std::size_t i)
+      {
+	if (unchanged(i))
+	  {
+	    next[i] = runs[i];
+	    return runs[i]->score;
+	  }
+	options::Map copy = maps[i];
+	if (not opts.resume)
+	  { return Ant::run(*this, copy); }
+	const vector<unsigned int>* path{nullptr};
+	if (fresh[i])
+	  {
+	    copy.checkpoint(fresh[i].get());
+	    if (parent(i))
+	      {
+		copy.resume(*runs[i], from[i]);
+		path = &paths[i];
+	      }
+	  }
+	const int s = Ant::run(*this, copy, path);
+	if (fresh[i])
+	  {
+	    fresh[i]->score = s;
+	    fresh[i]->max_ticks = copy.max_ticks;
+	    next[i] = fresh[i];
+	  }
+	return s;
+      };
+
+    score = 0;
+    if (opts.parallel_size > 0 and get_total() >= opts.parallel_size
+	and maps.size() > 1)
+      {
+	vector<std::future<int>> scores;
+	scores.reserve(maps.size());
+	for (std::size_t i{0}; i < maps.size(); ++i)
+	  scores.push_back(async(std::launch::async, play, i));
+	for (auto& s : scores)
+	  { score += s.get(); }
+      }
+    else
+      {
+	int remaining = total;
+	for (std::size_t i{0}; i < maps.size(); ++i)
+	  {
+	    // Stop if even eating all remaining food cannot beat threshold.
+	    if (score + remaining - cost < threshold)
+	      { break; }
+	    remaining -= maps[i].max();
+	    score += play(i);
+	  }
+      }
+
+    runs = std::move(next);
+    resume.clear();
+
+    adjusted = static_cast<float>(score) / total;
+    fitness = score - cost;
+  }
+
+  // Returns the ant's trace on each map, for plotting.
+  template<> std::string
+  Individual<Ant>::plot(const options::Options& opts) const
+  {
+    std::string traces;
+    for (auto map : opts.maps)
+      {
+	options::Trace trace;
+	map.record(&trace);
+	Ant::run(*this, map);
+	traces += map.print(trace);
+      }
+    return traces;
+  }
+
+  /* Forget evaluation history and compiled code of a tree changed at
+     the given node (before the change), and lower the entries its
+     runs can resume from to that node's first. */
+  template<> void
+  Individual<Ant>::modified(const Node<Ant>& changed)
+  {
+    auto& runs = state.runs;
+    auto& resume = state.resume;
+    state.evaluations = 0;
+    state.compiled.reset();
+
+    if (changed.id < 0)
+      {
+	// Within an earlier change, which bounds the entries already.
+	if (resume.empty())
+	  { runs.clear(); }
+	return;
+      }
+    if (resume.empty())
+      { resume.assign(runs.size(), options::Run::never); }
+    for (std::size_t i{0}; i < runs.size(); ++i)
+      if (runs[i] and not runs[i]->entries.empty())
+	{ resume[i] = std::min(resume[i], runs[i]->entered[changed.id]); }
+  }
+
+  // Unnumbers a replacement for runs that will resume.
+  template<> void
+  Individual<Ant>::replaced(Node<Ant>& replacement, int id)
+  {
+    if (not state.runs.empty())
+      { Ant::forget(replacement, id); }
+  }
+}
@@ -0,0 +1,169 @@
+/* ant.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for the artificial ant problem
+ */
+
+#ifndef _ANT_H_
+#define _ANT_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../individual/individual.hpp"
+#include "../individual/primitives.hpp"
+#include "../options/options.hpp"
+
+namespace jit { class Program; }
+
+namespace problem
+{
+  /* The artificial ant: a program steers an ant across each map of
+     the training set until it is out of ticks, scoring the food it
+     eats.  Its primitives act on the map rather than return values. */
+  struct Ant
+  {
+    enum class Function {nil, prog2, prog3, iffoodahead, left, right, forward};
+    typedef void Value;
+    typedef options::Map Context;
+    typedef std::vector<options::Map> Cases;
+    typedef individual::Node<Ant> Node;
+    typedef individual::Individual<Ant> Individual;
+
+    template<Function> struct Primitive;
+
+    // The primitives of the ant's expressions.
+    typedef individual::Registry<Ant, Function::prog2, Function::prog3,
+				 Function::iffoodahead, Function::left,
+				 Function::right, Function::forward> Primitives;
+
+    // Each individual's compiled code and checkpointed runs.
+    struct State
+    {
+      int evaluations;
+      std::shared_ptr<const jit::Program> compiled;
+      std::vector<std::shared_ptr<const options::Run>> runs;
+      std::vector<int> resume;
+      State();
+    };
+
+    static const Cases& cases(const options::Options&);
+    static Cases brood(const Cases&, float);
+    static void evaluate(const std::vector<Individual*>&, const Cases&,
+			 const options::Options&, float);
+    static const char* const extension;
+
+  private:
+    friend class individual::Individual<Ant>;
+    struct Numbering;
+    struct Lane;
+    static bool step(Lane&);
+    static int run(const Individual&, options::Map&,
+		   const std::vector<unsigned int>* = nullptr);
+    static void renumber(Individual&,
+			 std::vector<std::shared_ptr<options::Run>>&,
+			 const std::vector<std::size_t>&,
+			 std::vector<std::vector<unsigned int>>&);
+    static void number(const Individual&, Node&, Numbering&);
+    static void forget(Node&, int);
+    static void resume(const Node&, const std::vector<unsigned int>&,
+		       std::size_t, options::Map&);
+  };
+}
+
+// The ant's evaluation, specialized in ant.cpp.
+namespace individual
+{
+  template<> void
+  Node<problem::Ant>::evaluate(options::Map&) const;
+
+  template<> void
+  Individual<problem::Ant>::evaluate(const problem::Ant::Cases&,
+				     const options::Options&, float);
+
+  template<> std::string
+  Individual<problem::Ant>::plot(const options::Options&) const;
+
+  template<> void
+  Individual<problem::Ant>::modified(const Node<problem::Ant>&);
+
+  template<> void
+  Individual<problem::Ant>::replaced(Node<problem::Ant>&, int);
+}
+
+// The primitives of the ant.
+namespace problem
+{
+  template<>
+  struct Ant::Primitive<Ant::Function::prog2>
+  {
+    static constexpr unsigned int arity = 2;
+    static constexpr const char* name = "prog-2";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node& node, options::Map& map)
+    {
+      for (const auto& child : node.children)
+	{ child.evaluate(map); }
+    }
+  };
+
+  template<>
+  struct Ant::Primitive<Ant::Function::prog3>
+  {
+    static constexpr unsigned int arity = 3;
+    static constexpr const char* name = "prog-3";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node& node, options::Map& map)
+    { Primitive<Function::prog2>::evaluate(node, map); }
+  };
+
+  template<>
+  struct Ant::Primitive<Ant::Function::iffoodahead>
+  {
+    static constexpr unsigned int arity = 2;
+    static constexpr const char* name = "if-food-ahead";
+    static constexpr bool conditional = true;
+    static void
+    evaluate(const Node& node, options::Map& map)
+    { node.children[map.look() ? 0 : 1].evaluate(map); }
+  };
+
+  template<>
+  struct Ant::Primitive<Ant::Function::left>
+  {
+    static constexpr unsigned int arity = 0;
+    static constexpr const char* name = "left";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node&, options::Map& map)
+    { map.left(); }
+  };
+
+  template<>
+  struct Ant::Primitive<Ant::Function::right>
+  {
+    static constexpr unsigned int arity = 0;
+    static constexpr const char* name = "right";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node&, options::Map& map)
+    { map.right(); }
+  };
+
+  template<>
+  struct Ant::Primitive<Ant::Function::forward>
+  {
+    static constexpr unsigned int arity = 0;
+    static constexpr const char* name = "forward";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node&, options::Map& map)
+    { map.forward(); }
+  };
+}
+
+#endif /* _ANT_H_ */
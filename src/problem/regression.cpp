@@ -0,0 +1,170 @@
+/* regression.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for the symbolic regression problem
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "regression.hpp"
+#include "../metrics/metrics.hpp"
+#include "../options/options.hpp"
+
+namespace problem
+{
+  constexpr double Regression::tolerance;
+
+  // Expressions are fitted to the samples.
+  const Regression::Cases&
+  Regression::cases(const options::Options& opts)
+  { return *opts.samples; }
+
+  /* Broods are evaluated on fewer samples, evenly spaced: a tenth
+     plus [0, 1] of the rest, where 0 is the first generation and 1 is
+     the final generation (as the ant's ticks are scaled).  Every brood
+     of a generation shares its subset, so each thread (trial) keeps
+     its last rather than copying the columns per brood. */
+  const Regression::Cases&
+  Regression::brood(const Cases& samples, float scale)
+  {
+    const std::size_t min = 0.1 * samples.size();
+    const std::size_t count = std::max<std::size_t>(
+      1, min + scale * (samples.size() - min));
+
+    thread_local const Cases* source{nullptr};
+    thread_local Cases scaled;
+    if (source == &samples and scaled.size() == count)
+      { return scaled; }
+
+    source = &samples;
+    scaled.x.resize(count);
+    scaled.y.resize(count);
+    for (std::size_t i{0}; i < count; ++i)
+      {
+	const std::size_t j = i * samples.size() / count;
+	scaled.x[i] = samples.x[j];
+	scaled.y[i] = samples.y[j];
+      }
+    return scaled;
+  }
+
+  // Evaluates a batch of expressions in turn (each already blocked).
+  void
+  Regression::evaluate(const std::vector<Individual*>& batch,
+		       const Cases& samples, const options::Options& opts,
+		       float threshold)
+  {
+    for (auto individual : batch)
+      { individual->evaluate(samples, opts, threshold); }
+  }
+
+  // Each sample with its prediction, for plotting.
+  const char* const Regression::extension = ".fit";
+
+  // The configured error of the given sums over rows samples.
+  double
+  Regression::error(const kernels::Errors& errors, std::size_t rows,
+		    const options::Options& opts)
+  {
+    return opts.error == "rmse" ? std::sqrt(errors.squared / rows)
+      : errors.absolute / rows;
+  }
+}
+
+namespace
+{
+  /* The buffers of the calling thread's evaluations, grown to the
+     deepest tree yet: one block per level of the tree. */
+  double*
+  buffers(int depth)
+  {
+    thread_local std::vector<double> buffers;
+    const std::size_t size = (depth + 1) * kernels::width;
+    if (buffers.size() < size)
+      { buffers.resize(size); }
+    return buffers.data();
+  }
+}
+
+namespace individual
+{
+  using problem::Regression;
+
+  // Evaluates an expression over a block, dispatching to each primitive.
+  template<> void
+  Node<Regression>::evaluate(Regression::Block& block) const
+  {
+    METRICS_COUNT(nodes, block.n);
+    assert(function != Function::nil); // Never evaluate empty node
+    Regression::Primitives::evaluate(*this, block);
+  }
+
+  /* Evaluate Individual on every sample, a block at a time, with the
+     negated error (less the size penalty) as fitness, and one over
+     one plus it as adjusted fitness.  When racing (a finite
+     threshold), evaluation stops once the error so far exceeds the
+     threshold; the partial error is then kept, as errors only add,
+     so its fitness is provably below it.  An error that is not a
+     number (say, of an overflow) makes the fitness not a number, and
+     so the least fit. */
+  template<> void
+  Individual<Regression>::evaluate(const Regression::Cases& samples,
+				   const options::Options& opts,
+				   float threshold)
+  {
+    const float cost = opts.penalty * get_total();
+
+    double* const out = buffers(get_depth());
+    kernels::Errors errors;
+    for (std::size_t row{0}; row < samples.size(); row += kernels::width)
+      {
+	Regression::Block block{&samples.x[row],
+	    std::min(kernels::width, samples.size() - row), out};
+	root.evaluate(block);
+	kernels::errors(out, &samples.y[row], block.n, Regression::tolerance,
+			errors);
+	if (-Regression::error(errors, samples.size(), opts) - cost
+	    < threshold)
+	  { break; }
+      }
+    METRICS_COUNT(evaluations, 1);
+
+    score = errors.hits;
+    const double error = Regression::error(errors, samples.size(), opts);
+    adjusted = 1 / (1 + error);
+    fitness = -error - cost;
+  }
+
+  // Returns each sample with the expression's prediction, for plotting.
+  template<> std::string
+  Individual<Regression>::plot(const options::Options& opts) const
+  {
+    const auto& samples = *opts.samples;
+    std::vector<double> out((get_depth() + 1) * kernels::width);
+    kernels::Errors errors;
+    std::ostringstream fit;
+    fit << "# x y prediction\n";
+    for (std::size_t row{0}; row < samples.size(); row += kernels::width)
+      {
+	Regression::Block block{&samples.x[row],
+	    std::min(kernels::width, samples.size() - row), out.data()};
+	root.evaluate(block);
+	kernels::errors(out.data(), &samples.y[row], block.n,
+			Regression::tolerance, errors);
+	for (std::size_t i{0}; i < block.n; ++i)
+	  {
+	    fit << samples.x[row + i] << ' ' << samples.y[row + i] << ' '
+		<< out[i] << '\n';
+	  }
+      }
+    fit << "# mae " << errors.absolute / samples.size()
+	<< ", rmse " << std::sqrt(errors.squared / samples.size())
+	<< ", hits " << errors.hits << '\n';
+    return fit.str();
+  }
+}
@@ -0,0 +1,205 @@
+/* regression.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for the symbolic regression problem
+ */
+
+#ifndef _REGRESSION_H_
+#define _REGRESSION_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "../individual/individual.hpp"
+#include "../individual/primitives.hpp"
+#include "../kernels/kernels.hpp"
+#include "../options/options.hpp"
+
+namespace problem
+{
+  /* Symbolic regression: a program is an arithmetic expression of x,
+     fitted to the samples of a dataset (by default test/cs472.dat)
+     by its mean absolute (or root mean squared) error.  Its score is
+     its hits, the samples it predicts within the tolerance.
+     Expressions are evaluated a block of rows at a time, each node
+     over the whole block with a vectorized kernel. */
+  struct Regression
+  {
+    enum class Function {nil, add, subtract, multiply, divide, x, one, two, five};
+    typedef void Value;
+    typedef options::Samples Cases;
+    typedef individual::Node<Regression> Node;
+    typedef individual::Individual<Regression> Individual;
+
+    /* A block of rows in evaluation: its n values of x, and where the
+       node being evaluated writes its n results.  Above out are the
+       buffers of deeper nodes, kernels::width apart, so a function
+       keeps its left operand in out while its right is evaluated into
+       the next buffer. */
+    struct Block
+    {
+      const double* x;
+      std::size_t n;
+      double* out;
+    };
+    typedef Block Context;
+
+    template<Function> struct Primitive;
+
+    // The primitives of arithmetic expressions.
+    typedef individual::Registry<Regression, Function::add,
+				 Function::subtract, Function::multiply,
+				 Function::divide, Function::x, Function::one,
+				 Function::two, Function::five> Primitives;
+
+    // Expressions keep nothing between evaluations.
+    struct State {};
+
+    static constexpr double tolerance = 1;
+
+    static const Cases& cases(const options::Options&);
+    static const Cases& brood(const Cases&, float);
+    static void evaluate(const std::vector<Individual*>&, const Cases&,
+			 const options::Options&, float);
+    static const char* const extension;
+
+  private:
+    friend class individual::Individual<Regression>;
+    typedef void (*Kernel)(double*, const double*, std::size_t);
+    static void apply(const Node&, Block&, Kernel);
+    static double error(const kernels::Errors&, std::size_t,
+			const options::Options&);
+  };
+}
+
+// The evaluation of expressions, specialized in regression.cpp.
+namespace individual
+{
+  template<> void
+  Node<problem::Regression>::evaluate(problem::Regression::Block&) const;
+
+  template<> void
+  Individual<problem::Regression>::evaluate(const problem::Regression::Cases&,
+					    const options::Options&, float);
+
+  template<> std::string
+  Individual<problem::Regression>::plot(const options::Options&) const;
+
+  // Nothing is kept that a change would invalidate.
+  template<> inline void
+  Individual<problem::Regression>::modified(const Node<problem::Regression>&)
+  {}
+
+  template<> inline void
+  Individual<problem::Regression>::replaced(Node<problem::Regression>&, int)
+  {}
+}
+
+// The primitives of arithmetic expressions.
+namespace problem
+{
+  // Evaluates both operands over the block, combining them by kernel.
+  inline void
+  Regression::apply(const Node& node, Block& block, Kernel kernel)
+  {
+    double* const out = block.out;
+    node.children[0].evaluate(block);
+    block.out = out + kernels::width;
+    node.children[1].evaluate(block);
+    block.out = out;
+    kernel(out, out + kernels::width, block.n);
+  }
+
+  template<>
+  struct Regression::Primitive<Regression::Function::add>
+  {
+    static constexpr unsigned int arity = 2;
+    static constexpr const char* name = "+";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node& node, Block& block)
+    { apply(node, block, kernels::add); }
+  };
+
+  template<>
+  struct Regression::Primitive<Regression::Function::subtract>
+  {
+    static constexpr unsigned int arity = 2;
+    static constexpr const char* name = "-";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node& node, Block& block)
+    { apply(node, block, kernels::subtract); }
+  };
+
+  template<>
+  struct Regression::Primitive<Regression::Function::multiply>
+  {
+    static constexpr unsigned int arity = 2;
+    static constexpr const char* name = "*";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node& node, Block& block)
+    { apply(node, block, kernels::multiply); }
+  };
+
+  // Protected division, which is one when dividing by zero.
+  template<>
+  struct Regression::Primitive<Regression::Function::divide>
+  {
+    static constexpr unsigned int arity = 2;
+    static constexpr const char* name = "/";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node& node, Block& block)
+    { apply(node, block, kernels::divide); }
+  };
+
+  template<>
+  struct Regression::Primitive<Regression::Function::x>
+  {
+    static constexpr unsigned int arity = 0;
+    static constexpr const char* name = "x";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node&, Block& block)
+    { std::copy(block.x, block.x + block.n, block.out); }
+  };
+
+  template<>
+  struct Regression::Primitive<Regression::Function::one>
+  {
+    static constexpr unsigned int arity = 0;
+    static constexpr const char* name = "1";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node&, Block& block)
+    { kernels::fill(block.out, 1, block.n); }
+  };
+
+  template<>
+  struct Regression::Primitive<Regression::Function::two>
+  {
+    static constexpr unsigned int arity = 0;
+    static constexpr const char* name = "2";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node&, Block& block)
+    { kernels::fill(block.out, 2, block.n); }
+  };
+
+  template<>
+  struct Regression::Primitive<Regression::Function::five>
+  {
+    static constexpr unsigned int arity = 0;
+    static constexpr const char* name = "5";
+    static constexpr bool conditional = false;
+    static void
+    evaluate(const Node&, Block& block)
+    { kernels::fill(block.out, 5, block.n); }
+  };
+}
+
+#endif /* _REGRESSION_H_ */
@@ -0,0 +1,172 @@
+/* profile.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for profile namespace
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "profile.hpp"
+
+namespace profile
+{
+  const char* phase_names[] = {"variation", "evaluation"};
+  const char* event_names[] = {"cycles", "instructions", "cache-misses",
+			       "branch-misses"};
+
+  // The calling thread's session, and whether a scope is counting.
+  thread_local Session* active{nullptr};
+  thread_local bool counting{false};
+
+  /* Open the events as one group (led by the first to open), so they
+     are scheduled, and read, together. */
+  Session::Session(): leader{-1}, opened{0}, totals{}, evaluations{0}, nodes{0}
+  {
+    for (int e{0}; e < events; ++e)
+      { fds[e] = indexes[e] = -1; }
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+    const std::uint64_t configs[events] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int e{0}; e < events; ++e)
+      {
+	perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = configs[e];
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED
+	  | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	const int fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+	if (fd < 0)
+	  {
+	    if (error.empty())
+	      { error = std::string{event_names[e]} + ": " + std::strerror(errno); }
+	    continue;
+	  }
+	fds[e] = fd;
+	indexes[e] = opened++;
+	if (leader < 0)
+	  { leader = fd; }
+      }
+#else
+    error = "perf_event_open is not available on this system";
+#endif
+
+    if (opened > 0)
+      { active = this; }
+  }
+
+  Session::~Session()
+  {
+    if (active == this)
+      { active = nullptr; }
+#ifdef HAVE_LINUX_PERF_EVENT_H
+    for (int e{0}; e < events; ++e)
+      if (fds[e] >= 0)
+	{ close(fds[e]); }
+#endif
+  }
+
+  /* Read the group, scaling counts up if the kernel multiplexed it
+     (ran it for only part of the time it was enabled). */
+  bool
+  Session::read(double values[events]) const
+  {
+#ifdef HAVE_LINUX_PERF_EVENT_H
+    std::uint64_t buffer[3 + events]; // nr, enabled, running, values
+    if (::read(leader, buffer, sizeof(buffer)) < 0)
+      { return false; }
+    const double scale = buffer[2] > 0
+      ? static_cast<double>(buffer[1]) / buffer[2] : 0;
+    for (int e{0}; e < events; ++e)
+      { values[e] = indexes[e] < 0 ? 0 : buffer[3 + indexes[e]] * scale; }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // Returns the totals and their ratios as lines for a trial's log.
+  std::string
+  Session::report() const
+  {
+    std::stringstream out;
+    if (opened == 0)
+      {
+	out << "# Profile: hardware counters unavailable (" << error << ")\n";
+	return out.str();
+      }
+
+    out << "# Profile: " << evaluations << " evaluations of "
+	<< nodes << " nodes\n";
+    if (not error.empty())
+      { out << "# Profile: some counters unavailable (" << error << ")\n"; }
+    for (int p{0}; p < phases; ++p)
+      {
+	out << "# Profile " << phase_names[p] << ":";
+	for (int e{0}; e < events; ++e)
+	  {
+	    out << (e == 0 ? " " : ", ") << event_names[e];
+	    if (indexes[e] < 0)
+	      { out << " n/a"; continue; }
+	    const double total = totals[p][e];
+	    out << " " << total << " ("
+		<< (evaluations ? total / evaluations : 0) << "/eval, "
+		<< (nodes ? total / nodes : 0) << "/node)";
+	  }
+	const double cycles = totals[p][static_cast<int>(Event::cycles)];
+	if (cycles > 0 and indexes[static_cast<int>(Event::instructions)] >= 0)
+	  { out << ", IPC "
+		<< totals[p][static_cast<int>(Event::instructions)] / cycles; }
+	out << "\n";
+      }
+    return out.str();
+  }
+
+  Scope::Scope(Phase p): phase{p}, session{counting ? nullptr : active}
+  {
+    if (session and session->read(start))
+      { counting = true; }
+    else
+      { session = nullptr; }
+  }
+
+  Scope::~Scope()
+  {
+    if (not session)
+      { return; }
+    double stop[static_cast<int>(Event::count)];
+    if (session->read(stop))
+      for (int e{0}; e < Session::events; ++e)
+	{ session->totals[static_cast<int>(phase)][e] += stop[e] - start[e]; }
+    counting = false;
+  }
+
+  void
+  evaluated(unsigned long n)
+  {
+    if (active)
+      {
+	++active->evaluations;
+	active->nodes += n;
+      }
+  }
+}
@@ -0,0 +1,70 @@
+/* profile.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for profile namespace
+ * counts hardware events of the algorithm's phases with perf_event_open
+ */
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include <string>
+
+namespace profile
+{
+  enum class Phase { variation, evaluation, count };
+
+  enum class Event { cycles, instructions, cache_misses, branch_misses, count };
+
+  /* Hardware counters of the calling thread (so of one trial), active
+     for the thread while the session lives.  If counters cannot be
+     opened (not Linux, no PMU, or perf_event_paranoid), the session
+     only records why, and scopes are free. */
+  class Session
+  {
+    friend class Scope;
+    friend void evaluated(unsigned long);
+
+  public:
+    Session();
+    ~Session();
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    std::string report() const;
+
+  private:
+    static const int phases = static_cast<int>(Phase::count);
+    static const int events = static_cast<int>(Event::count);
+    int fds[events];
+    int indexes[events]; // Position of each event in a group read.
+    int leader;
+    int opened;
+    std::string error;
+    double totals[phases][events];
+    unsigned long long evaluations;
+    unsigned long long nodes;
+    bool read(double values[events]) const;
+  };
+
+  // Accumulates the events of its scope into a phase (unless nested).
+  class Scope
+  {
+  public:
+    Scope(Phase);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    Phase phase;
+    Session* session;
+    double start[static_cast<int>(Event::count)];
+  };
+
+  // Counts an evaluation of a tree of the given size, when profiling.
+  void
+  evaluated(unsigned long nodes);
+}
+
+#endif /* _PROFILE_H_ */
@@ -0,0 +1,151 @@
+/* replay.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Rebuilds ant map plots from the traces saved by search.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include "generator/generator.hpp"
+#include "options/options.hpp"
+
+namespace
+{
+  struct Settings
+  {
+    std::string map;
+    int tick;
+    int every;
+  };
+
+  /* Replay one traced run on its map up to the last tick, printing the
+     map every so many ticks (for animation) and at the end. */
+  void
+  replay(const Settings& settings, const std::string& source, int ticks,
+	 int score, const std::string& actions)
+  {
+    const int last = (settings.tick >= 0 and settings.tick < ticks)
+      ? settings.tick : ticks;
+    const std::string& name = settings.map.empty() ? source : settings.map;
+    generator::Parameters trail;
+    options::Map map = generator::parse(name, trail)
+      ? generator::map(trail, last) : options::Map{name, last};
+
+    std::istringstream runs{actions};
+    char action;
+    int count, tick{0};
+    while (map.active() and runs >> action >> count)
+      for (int i{0}; i < count and map.active(); ++i)
+	{
+	  switch (static_cast<options::Action>(action))
+	    {
+	    case options::Action::forward:
+	      { map.forward(); break; }
+	    case options::Action::left:
+	      { map.left(); break; }
+	    case options::Action::right:
+	      { map.right(); break; }
+	    default:
+	      { throw std::runtime_error{"Trace had bad action " + std::string{action}}; }
+	    }
+	  ++tick;
+	  if (settings.every > 0 and tick % settings.every == 0 and map.active())
+	    { std::cout << "# tick " << tick << '\n' << map.print() << '\n'; }
+	}
+
+    if (last == ticks and map.fitness() != score)
+      {
+	std::cerr << "Replay of " << source << " scored " << map.fitness()
+		  << " but the trace recorded " << score << std::endl;
+      }
+    std::cout << "# tick " << tick << ", score " << map.fitness() << '\n'
+	      << map.print() << '\n';
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  using std::string;
+  using namespace boost::program_options;
+
+  string filename;
+  Settings settings;
+
+  options_description description{"Allowed options"};
+  description.add_options()
+    ("help,h", "produce help message")
+    ("trace", value<string>(&filename)->required(),
+     "set the trace file to replay")
+    ("map,m", value<string>(&settings.map),
+     "set the map file to replay on instead of the traced source")
+    ("tick,t", value<int>(&settings.tick)->default_value(-1),
+     "set the tick to stop the replay at (-1 for the whole run)")
+    ("every,e", value<int>(&settings.every)->default_value(0),
+     "also print the map every given number of ticks (0 to disable)");
+
+  positional_options_description positionals;
+  positionals.add("trace", 1);
+
+  variables_map variables_map;
+  try
+    {
+      store(command_line_parser(argc, argv).options(description)
+	    .positional(positionals).run(), variables_map);
+      if (variables_map.count("help"))
+	{
+	  std::cout << "Usage: antgp-replay <trace> [options]\n\n"
+		    << description << std::endl;
+	  return EXIT_SUCCESS;
+	}
+      notify(variables_map);
+    }
+  catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  std::ifstream trace{filename};
+  if (not trace)
+    {
+      std::cerr << "File " << filename << " could not be read!\n";
+      return EXIT_FAILURE;
+    }
+
+  // Each traced run is a map, ticks, score, actions and eaten line.
+  try
+    {
+      string line, key, source, actions;
+      int ticks{0}, score{0};
+      while (getline(trace, line))
+	{
+	  std::istringstream fields{line};
+	  fields >> key;
+	  if (key == "map")
+	    { getline(fields >> std::ws, source); }
+	  else if (key == "ticks")
+	    { fields >> ticks; }
+	  else if (key == "score")
+	    { fields >> score; }
+	  else if (key == "actions")
+	    { getline(fields, actions); }
+	  else if (key == "eaten")
+	    { replay(settings, source, ticks, score, actions); }
+	}
+    }
+  catch (const std::runtime_error& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
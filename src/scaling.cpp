@@ -0,0 +1,113 @@
+/* scaling.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Benchmark of ant evaluations per second on generated trails from
+ * 32x32 up to 16384x16384, at the configured trail density and seed,
+ * one at a time and interleaved (--interleave lanes, else 8).
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "generator/generator.hpp"
+#include "individual/individual.hpp"
+#include "options/options.hpp"
+#include "problem/ant.hpp"
+#include "random_generator/random_generator.hpp"
+
+int
+main(int argc, char* argv[])
+{
+  using std::setw;
+  using clock = std::chrono::steady_clock;
+
+  // Programs are created on the parsed maps, then timed on each size.
+  options::Options opts = options::parse(argc, argv);
+  random_generator::rg.engine.seed(0); // Same programs every run.
+
+  std::vector<problem::Ant::Individual> programs;
+  programs.reserve(opts.pop_size);
+  for (int i{0}; i < opts.pop_size; ++i)
+    { programs.emplace_back(opts); }
+  std::vector<problem::Ant::Individual*> batch;
+  for (auto& program : programs)
+    { batch.push_back(&program); }
+  options::Options interleaved = opts;
+  if (interleaved.interleave == 0)
+    { interleaved.interleave = 8; }
+  const float lowest = -std::numeric_limits<float>::infinity();
+
+  generator::Parameters trail;
+  const int width{12};
+  std::cout << std::left
+	    << setw(width) << "# size"
+	    << setw(width) << "food"
+	    << setw(width) << "bytes"
+	    << setw(width) << "evals/s"
+	    << setw(width) << "ticks/s"
+	    << setw(width) << "batch/s"
+	    << setw(width) << "speedup"
+	    << std::endl;
+
+  for (std::size_t size{32}; size <= 16384; size *= 2)
+    {
+      trail.width = trail.height = size;
+      const std::vector<options::Map> maps{
+	generator::map(trail, opts.maps.front().max_ticks)};
+
+      /* Check the interleaved scores against an untimed sequential
+	 pass over copies of the programs, in the same state. */
+      std::vector<problem::Ant::Individual> reference{programs};
+      for (auto& program : reference)
+	{ program.evaluate(maps, opts); }
+      problem::Ant::evaluate(batch, maps, interleaved, lowest);
+      for (std::size_t i{0}; i < programs.size(); ++i)
+	if (programs[i].get_score() != reference[i].get_score())
+	  {
+	    std::cerr << "Interleaved score " << programs[i].get_score()
+		      << " differs from " << reference[i].get_score() << std::endl;
+	    return EXIT_FAILURE;
+	  }
+
+      // Evaluate programs round-robin for at least a second.
+      long evaluations{0};
+      const auto start = clock::now();
+      std::chrono::duration<double> elapsed{0};
+      while (elapsed.count() < 1)
+	{
+	  programs[evaluations % programs.size()].evaluate(maps, opts);
+	  ++evaluations;
+	  elapsed = clock::now() - start;
+	}
+
+      const double rate = evaluations / elapsed.count();
+
+      // Time whole batches alike.
+      long batched{0};
+      const auto batch_start = clock::now();
+      elapsed = std::chrono::duration<double>{0};
+      while (elapsed.count() < 1)
+	{
+	  problem::Ant::evaluate(batch, maps, interleaved, lowest);
+	  batched += batch.size();
+	  elapsed = clock::now() - batch_start;
+	}
+      const double batch_rate = batched / elapsed.count();
+
+      std::cout << setw(width) << std::to_string(size) + "x" + std::to_string(size)
+		<< setw(width) << maps.front().max()
+		<< setw(width) << maps.front().memory()
+		<< setw(width) << rate
+		<< setw(width) << rate * maps.front().max_ticks
+		<< setw(width) << batch_rate
+		<< setw(width) << batch_rate / rate
+		<< std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
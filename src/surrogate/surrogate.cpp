@@ -0,0 +1,221 @@
+/* surrogate.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for surrogate namespace
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+
+#include "surrogate.hpp"
+#include "../options/options.hpp"
+#include "../problem/ant.hpp"
+#include "../problem/regression.hpp"
+#include "../random_generator/random_generator.hpp"
+
+namespace surrogate
+{
+  using individual::Individual;
+  using namespace random_generator;
+
+  // The calling thread's trial's model.
+  thread_local Model* active{nullptr};
+
+  // The weight kept of older observations at each update.
+  const double forget{0.5};
+
+  // Relative ridge added to the normal equations' diagonal.
+  const double ridge{1e-3};
+
+  template<typename Problem> Features
+  features(const Individual<Problem>& child, float parent)
+  {
+    const std::vector<int> counts = child.get_counts();
+    Features x;
+    x.reserve(counts.size() + 1);
+    x.push_back(child.get_depth());
+    x.insert(end(x), next(begin(counts)), end(counts)); // Past nil.
+    x.push_back(std::isfinite(parent) ? parent : 0);
+    return x;
+  }
+
+  Model::Model(const options::Options& opts)
+    : opts(opts), observed{0}, fitted{-1}, candidates{0}, evaluations{0},
+      pairs(), samples{0}, error{0}, correlations{0}, correlated{0}
+  {
+    if (opts.surrogate > 0)
+      { active = this; }
+  }
+
+  Model::~Model()
+  {
+    if (active == this)
+      { active = nullptr; }
+  }
+
+  bool
+  Model::ready() const
+  { return fitted >= 0; }
+
+  double
+  Model::predict(const Features& x) const
+  { return std::inner_product(begin(x), end(x), begin(weights), weights.back()); }
+
+  /* Ranks the candidates by their predictions: the top fraction (at
+     least the minimum) are evaluated, as is a sample of them all,
+     whatever their rank, by which the model's accuracy is measured
+     without bias. */
+  std::vector<Verdict>
+  Model::screen(const std::vector<double>& predictions, std::size_t minimum)
+  {
+    const std::size_t n = predictions.size();
+    const std::size_t top = std::min(n, std::max(minimum, static_cast<std::size_t>
+						 (std::ceil(opts.surrogate * n))));
+    std::vector<std::size_t> order(n);
+    std::iota(begin(order), end(order), 0);
+    std::nth_element(begin(order), begin(order) + top, end(order),
+		     [&predictions](std::size_t a, std::size_t b)
+		     { return predictions[a] > predictions[b]; });
+
+    std::vector<Verdict> verdicts(n, Verdict::rejected);
+    for (std::size_t i{0}; i < top; ++i)
+      { verdicts[order[i]] = Verdict::ranked; }
+    bool_dist sample_dist{opts.surrogate_sample};
+    for (auto& verdict : verdicts)
+      if (sample_dist(rg.engine))
+	{ verdict = Verdict::sampled; }
+
+    candidates += n;
+    evaluations += n - std::count(begin(verdicts), end(verdicts),
+				  Verdict::rejected);
+    return verdicts;
+  }
+
+  // Adds a fully evaluated child to the normal equations.
+  void
+  Model::observe(const Features& x, float fitness)
+  {
+    if (not std::isfinite(fitness))
+      { return; }
+    const std::size_t p = x.size() + 1; // With the bias.
+    if (normal.empty())
+      {
+	normal.assign(p * (p + 1), 0);
+	weights.assign(p, 0);
+      }
+    for (std::size_t i{0}; i < p; ++i)
+      {
+	const double xi = i < x.size() ? x[i] : 1;
+	double* row = &normal[i * (p + 1)];
+	for (std::size_t j{0}; j < p; ++j)
+	  { row[j] += xi * (j < x.size() ? x[j] : 1); }
+	row[p] += xi * fitness;
+      }
+    ++observed;
+  }
+
+  // Records a sampled child's prediction against its evaluation.
+  void
+  Model::scored(double prediction, float fitness, Verdict verdict)
+  {
+    if (verdict != Verdict::sampled or not std::isfinite(fitness))
+      { return; }
+    pairs.n += 1;
+    pairs.x += prediction;
+    pairs.y += fitness;
+    pairs.xx += prediction * prediction;
+    pairs.yy += static_cast<double>(fitness) * fitness;
+    pairs.xy += prediction * fitness;
+    pairs.error += std::abs(prediction - fitness);
+  }
+
+  /* Closes the generation's accuracy, then refits the weights by
+     Gaussian elimination of the (slightly ridged) normal equations,
+     once they hold twice as many observations as weights, and
+     forgets some of their weight. */
+  void
+  Model::update(int generation)
+  {
+    samples += static_cast<long>(pairs.n);
+    error += pairs.error;
+    const double spread = (pairs.n * pairs.xx - pairs.x * pairs.x)
+      * (pairs.n * pairs.yy - pairs.y * pairs.y);
+    if (pairs.n >= 3 and spread > 0)
+      {
+	correlations += (pairs.n * pairs.xy - pairs.x * pairs.y) / std::sqrt(spread);
+	++correlated;
+      }
+    pairs = Pairs();
+
+    const std::size_t p = weights.size();
+    if (p == 0 or observed < 2 * p)
+      { return; }
+    std::vector<double> a{normal};
+    for (std::size_t i{0}; i < p; ++i)
+      { a[i * (p + 1) + i] *= 1 + ridge; }
+    for (std::size_t c{0}; c < p; ++c)
+      {
+	std::size_t pivot{c};
+	for (std::size_t r{c + 1}; r < p; ++r)
+	  if (std::abs(a[r * (p + 1) + c]) > std::abs(a[pivot * (p + 1) + c]))
+	    { pivot = r; }
+	if (a[pivot * (p + 1) + c] == 0)
+	  { continue; } // A feature never seen keeps no weight.
+	std::swap_ranges(begin(a) + c * (p + 1), begin(a) + (c + 1) * (p + 1),
+			 begin(a) + pivot * (p + 1));
+	for (std::size_t r{0}; r < p; ++r)
+	  if (r != c)
+	    {
+	      const double factor = a[r * (p + 1) + c] / a[c * (p + 1) + c];
+	      for (std::size_t j{c}; j <= p; ++j)
+		{ a[r * (p + 1) + j] -= factor * a[c * (p + 1) + j]; }
+	    }
+      }
+    for (std::size_t i{0}; i < p; ++i)
+      {
+	const double d = a[i * (p + 1) + i];
+	weights[i] = d == 0 ? 0 : a[i * (p + 1) + p] / d;
+      }
+
+    for (auto& sum : normal)
+      { sum *= forget; }
+    observed *= forget;
+    if (fitted < 0)
+      { fitted = generation; }
+  }
+
+  // The candidates screened, evaluations saved, and accuracy, for the log.
+  std::string
+  Model::report() const
+  {
+    std::ostringstream report;
+    if (active != this)
+      { return report.str(); }
+    report.precision(3);
+    report << "# Surrogate: ";
+    if (not ready())
+      {
+	report << "never fit\n";
+	return report.str();
+      }
+    const long saved = candidates - evaluations;
+    report << "fit from generation " << fitted << "; " << evaluations
+	   << " of " << candidates << " candidates evaluated, " << saved
+	   << " evaluations saved (" << (candidates ? 100. * saved / candidates : 0)
+	   << "%); on " << samples << " sampled, mean absolute error "
+	   << (samples ? error / samples : 0) << ", mean correlation "
+	   << (correlated ? correlations / correlated : 0) << '\n';
+    return report.str();
+  }
+
+  Model*
+  model()
+  { return active; }
+
+  template Features
+  features(const Individual<problem::Ant>&, float);
+  template Features
+  features(const Individual<problem::Regression>&, float);
+}
@@ -0,0 +1,78 @@
+/* surrogate.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for surrogate namespace
+ * predicts children's fitness to evaluate only the promising ones
+ */
+
+#ifndef _SURROGATE_H_
+#define _SURROGATE_H_
+
+#include <string>
+#include <vector>
+
+#include "../individual/individual.hpp"
+
+// Forward declaration
+namespace options { struct Options; }
+
+namespace surrogate
+{
+  typedef std::vector<double> Features;
+
+  /* A child's features: its depth, its nodes of each function, and
+     its parent's fitness. */
+  template<typename Problem> Features
+  features(const individual::Individual<Problem>&, float parent);
+
+  // Whether a screened candidate is evaluated, and why.
+  enum class Verdict { rejected, ranked, sampled };
+
+  /* A linear model of fitness over children's features, for one
+     trial, active for its thread while it lives if --surrogate is
+     set.  Children fully evaluated in a generation are observed, and
+     each update refits the model by least squares, forgetting older
+     generations.  Once fit, it screens candidates: those it ranks in
+     the top fraction are evaluated, and each of a random sample (by
+     which its accuracy is measured) too. */
+  class Model
+  {
+  public:
+    Model(const options::Options&);
+    ~Model();
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    bool ready() const;
+    double predict(const Features&) const;
+    std::vector<Verdict> screen(const std::vector<double>& predictions,
+				std::size_t minimum = 1);
+    void observe(const Features&, float fitness);
+    void scored(double prediction, float fitness, Verdict);
+    void update(int generation);
+    std::string report() const;
+
+  private:
+    const options::Options& opts;
+    std::vector<double> weights;
+    std::vector<double> normal; // Normal equations, [X'X | X'y] by row.
+    double observed; // Weight of the observations held.
+    int fitted; // The generation first fit, or -1.
+    long candidates;
+    long evaluations;
+    struct Pairs // Predictions of one generation's sampled children.
+    {
+      double n, x, y, xx, yy, xy, error;
+    } pairs;
+    long samples;
+    double error;
+    double correlations;
+    int correlated;
+  };
+
+  // The calling thread's trial's model, if screening.
+  Model*
+  model();
+}
+
+#endif /* _SURROGATE_H_ */
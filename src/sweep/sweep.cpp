@@ -0,0 +1,206 @@
+/* sweep.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for sweep namespace
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+#include "sweep.hpp"
+#include "../algorithm/algorithm.hpp"
+#include "../individual/individual.hpp"
+#include "../logging/logging.hpp"
+#include "../options/options.hpp"
+#include "../problem/ant.hpp"
+#include "../problem/regression.hpp"
+#include "../termination/termination.hpp"
+
+namespace sweep
+{
+  using std::string;
+  using std::vector;
+
+  /* Options the sweep's parameter sets share, so may not set: the
+     maps (and their generated trails, options prefixed "trail-") are
+     built once, though each set may give them its own ticks. */
+  const char* shared[] = {"problem", "data", "file", "config", "sweep",
+			  "generate"};
+
+  vector<vector<string>>
+  read(const string& filename)
+  {
+    std::ifstream file{filename};
+    if (not file)
+      { throw std::runtime_error{"File " + filename + " could not be read!"}; }
+
+    vector<vector<string>> sets;
+    string line;
+    while (std::getline(file, line))
+      {
+	std::istringstream words{line.substr(0, line.find('#'))};
+	vector<vector<string>> grid{{}};
+	string word;
+	while (words >> word)
+	  {
+	    const std::size_t equals = word.find('=');
+	    if (equals == string::npos or equals == 0)
+	      { throw std::runtime_error{"File " + filename + " had a bad option!"}; }
+	    const string name = word.substr(0, equals);
+	    if (std::find(std::begin(shared), std::end(shared), name)
+		!= std::end(shared) or name.compare(0, 6, "trail-") == 0)
+	      {
+		throw std::runtime_error{"File " + filename + " sets " + name
+		    + ", which a sweep shares!"};
+	      }
+
+	    // Every set so far, once with each of this option's values.
+	    vector<vector<string>> expanded;
+	    std::istringstream values{word.substr(equals + 1)};
+	    string value;
+	    while (std::getline(values, value, ','))
+	      for (auto set : grid)
+		{
+		  set.push_back(name + "=" + value);
+		  expanded.push_back(set);
+		}
+	    if (expanded.empty())
+	      { throw std::runtime_error{"File " + filename + " had a bad option!"}; }
+	    grid = expanded;
+	  }
+	if (not grid.front().empty())
+	  { sets.insert(end(sets), begin(grid), end(grid)); }
+      }
+    if (sets.empty())
+      { throw std::runtime_error{"File " + filename + " had no parameter sets!"}; }
+    return sets;
+  }
+
+  /* Each worker takes the next (set, trial) pair until none are left,
+     so no core waits on another set's trials.  A set's termination
+     run starts with its first trial, and its later trials are skipped
+     once it is cancelled (by a trial reaching the target) or out of
+     budget. */
+  template<typename Problem> void
+  run(const std::time_t& time, int argc, char* argv[],
+      const options::Options& opts)
+  {
+    vector<vector<string>> sets;
+    try
+      { sets = read(opts.sweep); }
+    catch (const std::runtime_error& e)
+      {
+	std::cerr << e.what() << std::endl;
+	std::exit(EXIT_FAILURE);
+      }
+
+    // Each set's options, sharing the maps or samples; trials numbered on.
+    vector<options::Options> configs;
+    vector<int> firsts;
+    int jobs{0};
+    for (const auto& set : sets)
+      {
+	configs.push_back(options::parse(argc, argv, set, &opts));
+	firsts.push_back(jobs);
+	jobs += configs.back().trials;
+      }
+
+    vector<vector<algorithm::result_t<Problem>>> results(configs.size());
+    vector<vector<char>> ran(configs.size());
+    vector<std::unique_ptr<termination::Run>> runs(configs.size());
+    for (std::size_t c{0}; c < configs.size(); ++c)
+      {
+	results[c].resize(configs[c].trials);
+	ran[c].resize(configs[c].trials, false);
+      }
+
+    std::mutex mutex;
+    int next{0};
+    auto work = [&]
+      {
+	while (true)
+	  {
+	    std::size_t c{0};
+	    int trial;
+	    termination::Run* run;
+	    {
+	      std::lock_guard<std::mutex> lock{mutex};
+	      if (next == jobs)
+		{ return; }
+	      trial = next++;
+	      while (c + 1 < configs.size() and firsts[c + 1] <= trial)
+		{ ++c; }
+	      if (not runs[c])
+		{ runs[c].reset(new termination::Run); }
+	      run = runs[c].get();
+	    }
+
+	    const int t = trial - firsts[c];
+	    if (t > 0 and run->done(configs[c]) != termination::Reason::none)
+	      { continue; }
+	    results[c][t] =
+	      algorithm::genetic<Problem>(time, trial + 1, configs[c], *run);
+	    ran[c][t] = true;
+	  }
+      };
+
+    const unsigned long hardware_threads = std::thread::hardware_concurrency();
+    const unsigned long workers = std::min<unsigned long>(
+      hardware_threads != 0 ? hardware_threads : 2, jobs);
+    vector<std::thread> pool;
+    for (unsigned long w{0}; w < workers; ++w)
+      { pool.emplace_back(work); }
+    for (auto& worker : pool)
+      { worker.join(); }
+
+    // One row per set: its options, then its trials' results.
+    std::ofstream csv;
+    logging::open_log(csv, time, 0, opts.logs_dir, ".csv");
+    csv << "set,options,trials,first_trial,best_score,mean_score,"
+	<< "mean_time,mean_size\n";
+    for (std::size_t c{0}; c < configs.size(); ++c)
+      {
+	int trials{0}, best{0};
+	double scores{0}, times{0}, sizes{0};
+	for (int t{0}; t < configs[c].trials; ++t)
+	  if (ran[c][t])
+	    {
+	      const auto& solution = std::get<0>(results[c][t]);
+	      if (trials == 0 or solution.get_score() > best)
+		{ best = solution.get_score(); }
+	      scores += solution.get_score();
+	      times += std::get<1>(results[c][t]).count();
+	      sizes += solution.get_total();
+	      ++trials;
+	    }
+
+	string set;
+	for (const auto& option : sets[c])
+	  { set += (set.empty() ? "" : " ") + option; }
+	csv << c << ",\"" << set << "\"," << trials << ','
+	    << firsts[c] + 1 << ',' << best << ',' << scores / trials << ','
+	    << times / trials << ',' << sizes / trials << '\n';
+      }
+    csv.close();
+
+    std::cout << "Swept " << configs.size() << " parameter sets ("
+	      << jobs << " trials) on " << workers << " threads: "
+	      << opts.logs_dir << time << "_0.csv\n";
+  }
+
+  template void
+  run<problem::Ant>(const std::time_t&, int, char*[], const options::Options&);
+
+  template void
+  run<problem::Regression>(const std::time_t&, int, char*[],
+			   const options::Options&);
+}
@@ -0,0 +1,35 @@
+/* sweep.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for sweep namespace
+ * runs the trials of many parameter sets on one pool of threads
+ */
+
+#ifndef _SWEEP_H_
+#define _SWEEP_H_
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+// Forward declaration
+namespace options { struct Options; }
+
+namespace sweep
+{
+  /* Reads the parameter sets of a sweep: each line (less any comment
+     after #) is a grid of name=value,value,... options, expanded to
+     every combination of their values.  Throws std::runtime_error if
+     unreadable, or if a line sets what the sweep shares (the problem
+     and its data). */
+  std::vector<std::vector<std::string>>
+  read(const std::string&);
+
+  /* Runs every trial of every parameter set of the given options'
+     sweep on one pool of threads, sharing their maps or samples, and
+     writes a row of results per set to <logs>/<time>_0.csv. */
+  template<typename Problem> void
+  run(const std::time_t&, int, char*[], const options::Options&);
+}
+
+#endif /* _SWEEP_H_ */
@@ -0,0 +1,219 @@
+/* telemetry.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for telemetry namespace
+ */
+
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "telemetry.hpp"
+#include "../logging/logging.hpp"
+
+namespace telemetry
+{
+  const char magic[] = "ANTGPTEL";
+
+  // Seconds of the monotonic clock, comparable between processes.
+  double
+  now()
+  {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+  }
+
+  Page*
+  map(const std::string& path, bool create)
+  {
+    const int fd = create ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)
+      : open(path.c_str(), O_RDWR);
+    if (fd == -1)
+      { throw std::runtime_error{"File " + path + " could not be opened!"}; }
+
+    void* address{MAP_FAILED};
+    struct stat status;
+    if ((not create or ftruncate(fd, sizeof(Page)) == 0)
+	and fstat(fd, &status) == 0
+	and static_cast<std::size_t>(status.st_size) >= sizeof(Page))
+      {
+	address = mmap(nullptr, sizeof(Page), PROT_READ | PROT_WRITE,
+		       MAP_SHARED, fd, 0);
+      }
+    close(fd);
+    if (address == MAP_FAILED)
+      { throw std::runtime_error{"File " + path + " could not be mapped!"}; }
+
+    // The new page is zeroed, so every slot is empty and unstopped.
+    Page* page = static_cast<Page*>(address);
+    if (create)
+      {
+	page->pid = getpid();
+	std::memcpy(page->magic, magic, sizeof(page->magic));
+      }
+    else if (std::memcmp(page->magic, magic, sizeof(page->magic)) != 0)
+      {
+	munmap(address, sizeof(Page));
+	throw std::runtime_error{"File " + path + " is not a telemetry page!"};
+      }
+    return page;
+  }
+
+  /* Gives up (as if never published) after many tries, in case the
+     search was killed while writing the slot. */
+  bool
+  read(const Slot& slot, Snapshot& snapshot)
+  {
+    for (int tries{0}; tries < 1 << 16; ++tries)
+      {
+	const std::uint32_t sequence =
+	  slot.sequence.load(std::memory_order_acquire);
+	if (sequence == 0)
+	  { return false; }
+	if (sequence % 2 == 1)
+	  { continue; }
+
+	snapshot.trial = slot.trial.load(std::memory_order_relaxed);
+	snapshot.generation = slot.generation.load(std::memory_order_relaxed);
+	snapshot.score = slot.score.load(std::memory_order_relaxed);
+	snapshot.running = slot.running.load(std::memory_order_relaxed);
+	snapshot.avg_size = slot.avg_size.load(std::memory_order_relaxed);
+	snapshot.evaluations = slot.evaluations.load(std::memory_order_relaxed);
+	snapshot.rate = slot.rate.load(std::memory_order_relaxed);
+	snapshot.bytes = slot.bytes.load(std::memory_order_relaxed);
+	snapshot.seconds = slot.seconds.load(std::memory_order_relaxed);
+	snapshot.updated = slot.updated.load(std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+	  { return true; }
+      }
+    return false;
+  }
+
+  /* The seqlock's writer: the first increment (to odd) is ordered
+     before the fields by the release fence, and the second (to even)
+     after them by its release store. */
+  std::uint32_t
+  begin_write(Slot& slot)
+  {
+    const std::uint32_t sequence =
+      slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return sequence + 2;
+  }
+
+  void
+  end_write(Slot& slot, std::uint32_t sequence)
+  { slot.sequence.store(sequence, std::memory_order_release); }
+
+  int
+  index(int trial)
+  { return trial % Page::capacity; }
+
+  // Pages by path, mapped once per process (and never unmapped).
+  std::mutex mutex;
+  std::map<std::string, Page*> pages;
+
+  Publisher::Publisher(const std::string& path, int trial):
+    slot{nullptr}, path{path}, start{now()}, last{start}, previous{0}
+  {
+    if (path.empty())
+      { return; }
+
+    Page* page;
+    try
+      {
+	std::lock_guard<std::mutex> lock{mutex};
+	Page*& mapped = pages[path];
+	if (not mapped)
+	  { mapped = map(path, true); }
+	page = mapped;
+      }
+    catch (const std::runtime_error& e)
+      {
+	error = e.what();
+	return;
+      }
+
+    // Claim the slot (from any earlier trial), empty until published.
+    slot = &page->slots[index(trial)];
+    const std::uint32_t sequence = begin_write(*slot);
+    slot->stop.store(0, std::memory_order_relaxed);
+    slot->trial.store(trial, std::memory_order_relaxed);
+    slot->generation.store(-1, std::memory_order_relaxed);
+    slot->score.store(0, std::memory_order_relaxed);
+    slot->running.store(1, std::memory_order_relaxed);
+    slot->avg_size.store(0, std::memory_order_relaxed);
+    slot->evaluations.store(0, std::memory_order_relaxed);
+    slot->rate.store(0, std::memory_order_relaxed);
+    slot->bytes.store(0, std::memory_order_relaxed);
+    slot->seconds.store(0, std::memory_order_relaxed);
+    slot->updated.store(start, std::memory_order_relaxed);
+    end_write(*slot, sequence);
+  }
+
+  void
+  Publisher::publish(const logging::Record& record, long evaluations,
+		     long bytes)
+  {
+    if (not slot)
+      { return; }
+    const double time = now();
+    const std::uint32_t sequence = begin_write(*slot);
+    slot->generation.store(record.generation, std::memory_order_relaxed);
+    slot->score.store(record.score, std::memory_order_relaxed);
+    slot->running.store(1, std::memory_order_relaxed);
+    slot->avg_size.store(record.avg_size, std::memory_order_relaxed);
+    slot->evaluations.store(evaluations, std::memory_order_relaxed);
+    if (time > last)
+      {
+	slot->rate.store((evaluations - previous) / (time - last),
+			 std::memory_order_relaxed);
+      }
+    slot->bytes.store(bytes, std::memory_order_relaxed);
+    slot->seconds.store(time - start, std::memory_order_relaxed);
+    slot->updated.store(time, std::memory_order_relaxed);
+
+    end_write(*slot, sequence);
+    last = time;
+    previous = evaluations;
+  }
+
+  // Marks the trial finished, keeping its last snapshot.
+  Publisher::~Publisher()
+  {
+    if (not slot)
+      { return; }
+    const std::uint32_t sequence = begin_write(*slot);
+    slot->running.store(0, std::memory_order_relaxed);
+    slot->updated.store(now(), std::memory_order_relaxed);
+    end_write(*slot, sequence);
+  }
+
+  bool
+  Publisher::stopped() const
+  { return slot and slot->stop.load(std::memory_order_relaxed) != 0; }
+
+  // Where the trial was published (or why not), for the trial's log.
+  std::string
+  Publisher::report() const
+  {
+    std::ostringstream report;
+    if (slot)
+      { report << "# Published to " << path << "\n"; }
+    else if (not error.empty())
+      { report << "# Not published: " << error << "\n"; }
+    return report.str();
+  }
+}
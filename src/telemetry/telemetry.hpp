@@ -0,0 +1,104 @@
+/* telemetry.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for telemetry namespace
+ * publishes live per-trial statistics on a shared memory page
+ */
+
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Forward declaration
+namespace logging { struct Record; }
+
+namespace telemetry
+{
+  // A trial's latest statistics, as published once per generation.
+  struct Snapshot
+  {
+    int trial;
+    int generation;
+    int score;
+    float avg_size;
+    long evaluations;
+    double rate; // Evaluations per second over the last generation.
+    long bytes; // Of the population's trees.
+    double seconds; // Since the trial started.
+    double updated; // Of the monotonic clock, when published.
+    bool running;
+  };
+
+  /* A trial's slot on the page: its snapshot under a seqlock (the
+     sequence is odd while the trial writes it, so readers retry), and
+     a flag a client sets to stop the trial after its generation. */
+  struct alignas(64) Slot
+  {
+    std::atomic<std::uint32_t> sequence;
+    std::atomic<std::uint32_t> stop;
+    std::atomic<std::int32_t> trial;
+    std::atomic<std::int32_t> generation;
+    std::atomic<std::int32_t> score;
+    std::atomic<std::int32_t> running;
+    std::atomic<float> avg_size;
+    std::atomic<std::int64_t> evaluations;
+    std::atomic<double> rate;
+    std::atomic<std::int64_t> bytes;
+    std::atomic<double> seconds;
+    std::atomic<double> updated;
+  };
+
+  /* The page, a file (best on a tmpfs, say /dev/shm/antgp) created by
+     the search and mapped by clients.  Trial n uses slot n % capacity
+     (see index), so a single trial (numbered 0) uses the first. */
+  struct Page
+  {
+    static const int capacity{1024};
+    char magic[8];
+    std::int64_t pid;
+    Slot slots[capacity];
+  };
+
+  /* Maps the page at the path, created (and emptied) by the process
+     first publishing to it, or else existing; throws
+     std::runtime_error if it cannot. */
+  Page*
+  map(const std::string&, bool create);
+
+  // The slot of the page a trial uses.
+  int
+  index(int trial);
+
+  // Reads a consistent snapshot, false if the slot was never published.
+  bool
+  read(const Slot&, Snapshot&);
+
+  /* Publishes the calling thread's trial to the page while it lives,
+     if given a path: each publish is a few relaxed stores between two
+     increments of the slot's sequence, so never waits on readers. */
+  class Publisher
+  {
+  public:
+    Publisher(const std::string&, int trial);
+    ~Publisher();
+    Publisher(const Publisher&) = delete;
+    Publisher& operator=(const Publisher&) = delete;
+
+    void publish(const logging::Record&, long evaluations, long bytes);
+    bool stopped() const; // Whether a client asked the trial to stop.
+    std::string report() const;
+
+  private:
+    Slot* slot;
+    std::string path;
+    std::string error;
+    double start;
+    double last;
+    long previous; // Evaluations as last published.
+  };
+}
+
+#endif /* _TELEMETRY_H_ */
@@ -0,0 +1,133 @@
+/* termination.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for termination namespace
+ */
+
+#include <ctime>
+#include <limits>
+#include <sstream>
+
+#include "termination.hpp"
+#include "../options/options.hpp"
+
+namespace termination
+{
+  // The calling thread's trial.
+  thread_local Trial* active{nullptr};
+
+  const char* reasons[] = {"none", "generations", "target", "evaluations",
+			   "stagnation", "trial-time", "trial-cpu", "run-time",
+			   "run-cpu", "cancelled", "stopped"};
+
+  // Seconds of CPU time of the given clock.
+  double
+  seconds(clockid_t clock)
+  {
+    timespec now;
+    clock_gettime(clock, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+  }
+
+  // Seconds since start on the steady clock.
+  double
+  since(const std::chrono::steady_clock::time_point& start)
+  {
+    const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  Run::Run(): cancelled{false}, start{std::chrono::steady_clock::now()},
+	      cpu{seconds(CLOCK_PROCESS_CPUTIME_ID)} {}
+
+  void
+  Run::cancel()
+  { cancelled.store(true, std::memory_order_relaxed); }
+
+  Reason
+  Run::done(const options::Options& opts) const
+  {
+    if (cancelled.load(std::memory_order_relaxed))
+      { return Reason::cancelled; }
+    if (opts.run_time > 0 and since(start) >= opts.run_time)
+      { return Reason::run_time; }
+    if (opts.run_cpu > 0
+	and seconds(CLOCK_PROCESS_CPUTIME_ID) - cpu >= opts.run_cpu)
+      { return Reason::run_cpu; }
+    return Reason::none;
+  }
+
+  Trial::Trial(const options::Options& opts, Run& run)
+    : opts(opts), run(run), start{std::chrono::steady_clock::now()},
+      cpu{seconds(CLOCK_THREAD_CPUTIME_ID)}, evaluations{0}, generations{0},
+      improved{0}, fittest{-std::numeric_limits<float>::infinity()},
+      reason{Reason::none}
+  { active = this; }
+
+  Trial::~Trial()
+  { active = nullptr; }
+
+  /* Checks each criterion after the given generation, cheapest first.
+     The trial's CPU time is its own thread's, so it excludes maps
+     evaluated in parallel threads (see --parallel-size). */
+  bool
+  Trial::done(int generation, int score, float fitness)
+  {
+    generations = generation + 1;
+    if (fitness > fittest)
+      {
+	fittest = fitness;
+	improved = generation;
+      }
+
+    if (reason == Reason::stopped)
+      { return true; }
+
+    if (opts.target > 0 and score >= opts.target)
+      {
+	reason = Reason::target;
+	run.cancel();
+      }
+    else if (generations >= opts.generations)
+      { reason = Reason::generations; }
+    else if (opts.evaluations > 0 and evaluations >= opts.evaluations)
+      { reason = Reason::evaluations; }
+    else if (opts.stagnation > 0 and generation - improved >= opts.stagnation)
+      { reason = Reason::stagnation; }
+    else if (opts.trial_time > 0 and since(start) >= opts.trial_time)
+      { reason = Reason::trial_time; }
+    else if (opts.trial_cpu > 0
+	     and seconds(CLOCK_THREAD_CPUTIME_ID) - cpu >= opts.trial_cpu)
+      { reason = Reason::trial_cpu; }
+    else
+      { reason = run.done(opts); }
+    return reason != Reason::none;
+  }
+
+  void
+  Trial::stop()
+  { reason = Reason::stopped; }
+
+  long
+  Trial::evaluations_so_far() const
+  { return evaluations; }
+
+  // Why and when the trial stopped, for its log.
+  std::string
+  Trial::report() const
+  {
+    std::ostringstream report;
+    report << "# Stopped: " << reasons[static_cast<int>(reason)]
+	   << " after " << generations << " generations and "
+	   << evaluations << " evaluations\n";
+    return report.str();
+  }
+
+  void
+  evaluated(long count)
+  {
+    if (active)
+      { active->evaluations += count; }
+  }
+}
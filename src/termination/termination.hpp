@@ -0,0 +1,78 @@
+/* termination.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for termination namespace
+ * decides when trials stop: generations, target, budgets, stagnation
+ */
+
+#ifndef _TERMINATION_H_
+#define _TERMINATION_H_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+// Forward declaration
+namespace options { struct Options; }
+
+namespace termination
+{
+  enum class Reason { none, generations, target, evaluations, stagnation,
+		      trial_time, trial_cpu, run_time, run_cpu, cancelled,
+		      stopped };
+
+  /* Shared by the trials of a run: its start, for the run's budgets,
+     and whether a trial reached the target, cancelling the rest. */
+  class Run
+  {
+  public:
+    Run();
+    Run(const Run&) = delete;
+    Run& operator=(const Run&) = delete;
+
+    void cancel();
+    // The reason the whole run is over (or none).
+    Reason done(const options::Options&) const;
+
+  private:
+    std::atomic<bool> cancelled;
+    std::chrono::steady_clock::time_point start;
+    double cpu;
+  };
+
+  /* The criteria of one trial, active for its thread while it lives
+     and checked once per generation: the first enabled criterion met
+     stops it, and reaching the target cancels the run. */
+  class Trial
+  {
+    friend void evaluated(long);
+
+  public:
+    Trial(const options::Options&, Run&);
+    ~Trial();
+    Trial(const Trial&) = delete;
+    Trial& operator=(const Trial&) = delete;
+
+    bool done(int generation, int score, float fitness);
+    void stop(); // Stops after this generation (for a monitor).
+    long evaluations_so_far() const;
+    std::string report() const;
+
+  private:
+    const options::Options& opts;
+    Run& run;
+    std::chrono::steady_clock::time_point start;
+    double cpu;
+    long evaluations;
+    int generations;
+    int improved; // The generation of the fittest best so far.
+    float fittest;
+    Reason reason;
+  };
+
+  // Counts evaluations toward the calling thread's trial, if any.
+  void
+  evaluated(long count = 1);
+}
+
+#endif /* _TERMINATION_H_ */
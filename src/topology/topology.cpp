@@ -0,0 +1,237 @@
+/* topology.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Source file for topology namespace
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <tuple>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "topology.hpp"
+
+namespace topology
+{
+  const std::string sysfs{"/sys/devices/system/"};
+
+  // Reads a CPU list such as "0-3,8,10-11".
+  std::vector<int>
+  read_list(const std::string& filename)
+  {
+    std::vector<int> list;
+    std::ifstream file{filename};
+    std::string range;
+    while (std::getline(file, range, ','))
+      {
+	int first, last;
+	char dash;
+	std::istringstream bounds{range};
+	if (not (bounds >> first))
+	  { continue; }
+	last = (bounds >> dash >> last) ? last : first;
+	for (int cpu{first}; cpu <= last; ++cpu)
+	  { list.push_back(cpu); }
+      }
+    return list;
+  }
+
+  // Reads a single number, or returns the fallback.
+  int
+  read_number(const std::string& filename, int fallback)
+  {
+    std::ifstream file{filename};
+    int number;
+    return (file >> number) ? number : fallback;
+  }
+
+#ifdef __linux__
+  // The CPUs the calling thread may currently run on.
+  std::vector<int>
+  allowed()
+  {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+      for (int cpu{0}; cpu < CPU_SETSIZE; ++cpu)
+	if (CPU_ISSET(cpu, &set))
+	  { cpus.push_back(cpu); }
+    return cpus;
+  }
+
+  // Restricts the calling thread to the given CPUs, returning any error.
+  int
+  restrict_to(const std::vector<int>& cpus)
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu : cpus)
+      if (cpu >= 0 and cpu < CPU_SETSIZE)
+	{ CPU_SET(cpu, &set); }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  }
+
+  // Each node's CPUs, from the node directories (absent without NUMA).
+  std::map<int, int>
+  read_nodes()
+  {
+    std::map<int, int> nodes;
+    if (DIR* directory = opendir((sysfs + "node").c_str()))
+      {
+	while (const dirent* entry = readdir(directory))
+	  {
+	    int node;
+	    if (std::sscanf(entry->d_name, "node%d", &node) != 1)
+	      { continue; }
+	    const std::string list =
+	      sysfs + "node/" + entry->d_name + "/cpulist";
+	    for (const int cpu : read_list(list))
+	      { nodes[cpu] = node; }
+	  }
+	closedir(directory);
+      }
+    return nodes;
+  }
+#else
+  std::vector<int>
+  allowed()
+  { return {}; }
+
+  int
+  restrict_to(const std::vector<int>&)
+  { return ENOSYS; }
+
+  std::map<int, int>
+  read_nodes()
+  { return {}; }
+#endif
+
+  /* Reads every online (and allowed) CPU's core and package, and its
+     node (else its package), then orders them: each node's first
+     thread of each core, then the remaining siblings, dealt out
+     alternately between nodes. */
+  std::vector<Cpu>
+  read()
+  {
+    const std::vector<int> permitted = allowed();
+    const std::map<int, int> nodes = read_nodes();
+
+    std::map<int, std::vector<Cpu>> firsts, siblings;
+    std::set<std::tuple<int, int>> cores;
+    for (const int id : read_list(sysfs + "cpu/online"))
+      {
+	if (std::find(begin(permitted), end(permitted), id) == end(permitted))
+	  { continue; }
+	const std::string topology =
+	  sysfs + "cpu/cpu" + std::to_string(id) + "/topology/";
+	Cpu cpu{id, read_number(topology + "core_id", id),
+	    read_number(topology + "physical_package_id", 0), 0};
+	const auto node = nodes.find(id);
+	cpu.node = (node != end(nodes)) ? node->second : cpu.package;
+
+	if (cores.insert(std::make_tuple(cpu.package, cpu.core)).second)
+	  { firsts[cpu.node].push_back(cpu); }
+	else
+	  { siblings[cpu.node].push_back(cpu); }
+      }
+
+    std::vector<Cpu> ordered;
+    for (auto* group : {&firsts, &siblings})
+      {
+	for (std::size_t i{0}; ; ++i)
+	  {
+	    bool dealt{false};
+	    for (const auto& node : *group)
+	      if (i < node.second.size())
+		{
+		  ordered.push_back(node.second[i]);
+		  dealt = true;
+		}
+	    if (not dealt)
+	      { break; }
+	  }
+      }
+    return ordered;
+  }
+
+  const std::vector<Cpu>&
+  cpus()
+  {
+    static const std::vector<Cpu> cpus = read();
+    return cpus;
+  }
+
+  // Threads pinned to each CPU of cpus(), guarded by the mutex.
+  std::mutex mutex;
+  std::vector<int> threads;
+
+  Pin::Pin(bool enabled): slot{-1}
+  {
+    if (not enabled)
+      { return; }
+    if (cpus().empty())
+      {
+	error = "the CPU topology could not be read";
+	return;
+      }
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      threads.resize(cpus().size(), 0);
+      slot = std::min_element(begin(threads), end(threads)) - begin(threads);
+      ++threads[slot];
+    }
+
+    previous = allowed();
+    if (const int failed = restrict_to({cpus()[slot].id}))
+      {
+	error = std::string{"pinning failed: "} + std::strerror(failed);
+	std::lock_guard<std::mutex> lock{mutex};
+	--threads[slot];
+	slot = -1;
+      }
+  }
+
+  Pin::~Pin()
+  {
+    if (slot < 0)
+      { return; }
+    restrict_to(previous);
+    std::lock_guard<std::mutex> lock{mutex};
+    --threads[slot];
+  }
+
+  bool
+  Pin::pinned() const
+  { return slot >= 0; }
+
+  // Where the thread was pinned (or why not), for the trial's log.
+  std::string
+  Pin::report() const
+  {
+    std::ostringstream report;
+    if (slot >= 0)
+      {
+	const Cpu& cpu = cpus()[slot];
+	report << "# Pinned to CPU " << cpu.id << " (core " << cpu.core
+	       << ", package " << cpu.package << ", node " << cpu.node
+	       << ")\n";
+      }
+    else if (not error.empty())
+      { report << "# Not pinned: " << error << "\n"; }
+    return report.str();
+  }
+}
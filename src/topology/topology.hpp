@@ -0,0 +1,54 @@
+/* topology.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for topology namespace
+ * reads the CPU topology from sysfs and pins trials' threads to cores
+ */
+
+#ifndef _TOPOLOGY_H_
+#define _TOPOLOGY_H_
+
+#include <string>
+#include <vector>
+
+namespace topology
+{
+  // An online CPU with its physical core, package (socket) and NUMA node.
+  struct Cpu
+  {
+    int id;
+    int core;
+    int package;
+    int node;
+  };
+
+  /* The CPUs this process may run on, in the order threads are pinned
+     to them: alternating between nodes, and on each, one per physical
+     core before their hyper-threaded siblings.  Empty if the topology
+     cannot be read (say, not Linux). */
+  const std::vector<Cpu>&
+  cpus();
+
+  /* Pins the calling thread while it lives to the first CPU (in the
+     order above) with the fewest threads pinned, so concurrent trials
+     spread over cores and nodes; restores its affinity after.  Does
+     nothing if not enabled or the topology is unknown. */
+  class Pin
+  {
+  public:
+    Pin(bool);
+    ~Pin();
+    Pin(const Pin&) = delete;
+    Pin& operator=(const Pin&) = delete;
+
+    bool pinned() const;
+    std::string report() const;
+
+  private:
+    int slot; // Index into cpus(), or -1 if not pinned.
+    std::vector<int> previous; // The CPUs the thread could run on before.
+    std::string error;
+  };
+}
+
+#endif /* _TOPOLOGY_H_ */
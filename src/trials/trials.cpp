@@ -15,51 +15,58 @@
 #include "../individual/individual.hpp"
 #include "../logging/logging.hpp"
 #include "../options/options.hpp"
-
-// Forward declaration of algorithm::genetic
-namespace algorithm
-{
-  const result_t
-  genetic(const std::time_t&, int, const options::Options&);
-}
+#include "../problem/ant.hpp"
+#include "../problem/regression.hpp"
+#include "../termination/termination.hpp"
 
 namespace trials
 {
   using individual::Individual;
-
+  using algorithm::result_t;
 
   /* Delegate for run.  Given time, trial number, total trials, vector
      of candidate Individual solutions, and options, spawn the
      numbered trials in asynchronous threads, pushing results to
      candidates. */
-  void
-  push_results(const std::time_t&, int&, int, std::vector<algorithm::result_t>&,
-	       const options::Options&);
+  template<typename Problem> void
+  push_results(const std::time_t&, int&, int, std::vector<result_t<Problem>>&,
+	       const options::Options&, termination::Run&);
 
   /* Given time and options, spawn trials in blocks of the appropriate
      size for hardware (determined at runtime, defaulting to two), and
-     spawn any remaining trials.  Return the best Individual result
-     from the trials along with its trial number as a tuple. */
-  const std::tuple<int, algorithm::result_t>
+     spawn any remaining trials (unless the run was cancelled or is
+     out of budget).  Return the best Individual result from the
+     trials along with its trial number as a tuple. */
+  template<typename Problem>
+  const std::tuple<int, result_t<Problem>>
   run(const std::time_t& time, const options::Options& opts)
   {
     const unsigned long hardware_threads = std::thread::hardware_concurrency();
     const unsigned long blocks = (hardware_threads != 0) ? hardware_threads : 2;
 
     int trial = 0;
-    std::vector<algorithm::result_t> candidates;
+    std::vector<result_t<Problem>> candidates;
+    termination::Run run;
 
     // Run the genetic algorithm (program).
     if (opts.trials == 1) // Spawn single non-threaded trial.
-      { candidates.push_back(algorithm::genetic(time, trial, opts)); }
+      {
+	candidates.push_back(
+	  algorithm::genetic<Problem>(time, trial, opts, run));
+      }
     else // Spawn trials in separate threads.
       {
 	// Spawn trials in chunks of size blocks.
 	for (unsigned long t = 0; t < opts.trials / blocks; ++t)
-	  { push_results(time, trial, blocks, candidates, opts); }
+	  if (t == 0 or run.done(opts) == termination::Reason::none)
+	    { push_results(time, trial, blocks, candidates, opts, run); }
 
 	// Spawn remaining trials.
-	push_results(time, trial, opts.trials % blocks, candidates, opts);
+	if (candidates.empty() or run.done(opts) == termination::Reason::none)
+	  {
+	    push_results(time, trial, opts.trials % blocks, candidates, opts,
+			 run);
+	  }
       }
 
     // Log trials
@@ -73,7 +80,7 @@ namespace trials
     float time_sum{0};
     for (const auto& result : candidates)
       {
-	Individual solution;
+	Individual<Problem> solution;
 	std::chrono::duration<double> elapsed_time;
 	std::tie(solution, elapsed_time) = result;
 	score_sum += solution.get_score();
@@ -83,14 +90,15 @@ namespace trials
 	    << setw(width) << elapsed_time.count()
 	    << endl;
       }
-    log << setw(width) << "# " << score_sum / opts.trials
-	<< setw(width) << time_sum / opts.trials
-	<< setw(width) << (score_sum / time_sum) / opts.trials
+    const int trials = candidates.size();
+    log << setw(width) << "# " << score_sum / trials
+	<< setw(width) << time_sum / trials
+	<< setw(width) << (score_sum / time_sum) / trials
 	<< endl;
     log.close();
 
     // Retrieve best element.
-    auto compare = [](const algorithm::result_t& a, const algorithm::result_t& b)
+    auto compare = [](const result_t<Problem>& a, const result_t<Problem>& b)
       { return std::get<0>(a).get_score() > std::get<0>(b).get_score(); };
     auto best = min_element(begin(candidates), end(candidates), compare);
 
@@ -99,18 +107,19 @@ namespace trials
     return std::make_tuple(distance(begin(candidates), best) + 1, *best);
   }
 
-  void
+  template<typename Problem> void
   push_results(const std::time_t& time, int& trial, int trials,
-	       std::vector<algorithm::result_t>& candidates,
-	       const options::Options& opts)
+	       std::vector<result_t<Problem>>& candidates,
+	       const options::Options& opts, termination::Run& run)
   {
     // Spawn blocks number of async threads.
-    std::vector<std::future<const algorithm::result_t>> results;
+    std::vector<std::future<const result_t<Problem>>> results;
     results.reserve(trials);
 
-    auto task = [&time, &trial, &opts]() mutable
-      { return async(std::launch::async,
-		     algorithm::genetic, time, ++trial, opts); };
+    auto task = [&time, &trial, &opts, &run]() mutable
+      { return async(std::launch::async, algorithm::genetic<Problem>, time,
+		     ++trial, std::cref(opts), std::ref(run),
+		     algorithm::Monitor{}); };
 
     generate_n(back_inserter(results), trials, task);
 
@@ -118,4 +127,11 @@ namespace trials
     for (auto& result : results)
       { candidates.push_back(result.get()); }
   }
+
+  // The trials of each problem.
+  template const std::tuple<int, result_t<problem::Ant>>
+  run<problem::Ant>(const std::time_t&, const options::Options&);
+
+  template const std::tuple<int, result_t<problem::Regression>>
+  run<problem::Regression>(const std::time_t&, const options::Options&);
 }
@@ -16,7 +16,8 @@ namespace options { struct Options; }
 
 namespace trials
 {
-  const std::tuple<int, algorithm::result_t>
+  template<typename Problem>
+  const std::tuple<int, algorithm::result_t<Problem>>
   run(const std::time_t&, const options::Options&);
 }
 
@@ -0,0 +1,51 @@
+/* check.hpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Header file for the tests run by make check
+ * counts and reports failed checks
+ */
+
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace check
+{
+  // Failed checks of the test so far.
+  inline int&
+  failures()
+  {
+    static int count{0};
+    return count;
+  }
+
+  // Reports a failed check with its description.
+  inline void
+  expect(bool passed, const std::string& description)
+  {
+    if (not passed)
+      {
+	std::cerr << "FAIL: " << description << std::endl;
+	++failures();
+      }
+  }
+
+  // The path of a file in the source tree (which make check gives).
+  inline std::string
+  source(const std::string& path)
+  {
+    const char* srcdir = std::getenv("srcdir");
+    return std::string{srcdir and std::strlen(srcdir) ? srcdir : "."} + "/" + path;
+  }
+
+  // The test's exit status.
+  inline int
+  status()
+  { return failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE; }
+}
+
+#endif /* _CHECK_H_ */
@@ -0,0 +1,96 @@
+/* jit.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Differential tests of the JIT: random programs compiled to native
+ * code must score exactly as the interpreter on every map
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "individual/individual.hpp"
+#include "jit/jit.hpp"
+#include "options/options.hpp"
+#include "problem/ant.hpp"
+#include "random_generator/random_generator.hpp"
+
+namespace
+{
+  using check::expect;
+  using individual::Method;
+  using options::Cell;
+  using options::Map;
+  using problem::Ant;
+  using random_generator::rg;
+  using std::to_string;
+
+  // A grid of the given size with food in about the given fraction of cells.
+  Map
+  random_map(std::size_t width, std::size_t height, double density, int ticks)
+  {
+    std::vector<std::vector<Cell>> cells(height, std::vector<Cell>(width));
+    std::bernoulli_distribution food{density};
+    for (auto& row : cells)
+      for (auto& cell : row)
+	{ cell = food(rg.engine) ? Cell::food : Cell::blank; }
+    return Map{cells, ticks};
+  }
+
+  // Runs the tree in the interpreter, as Ant does.
+  int
+  interpret(const Ant::Node& root, Map map)
+  {
+    while (map.active())
+      { Ant::Primitives::evaluate(root, map); }
+    return map.fitness();
+  }
+
+  // Runs the compiled program on a copy of the map.
+  int
+  native(const jit::Program& program, Map map)
+  {
+    program.run(map);
+    return map.fitness();
+  }
+}
+
+int
+main()
+{
+  if (not jit::supported())
+    { return 77; } // Skipped.
+
+  rg.engine.seed(472);
+  /* The Santa Fe trail, small maps which wrap often (with sides not
+     powers of two), and a map large enough for its visited cells to
+     be hashed rather than a bitset. */
+  const std::vector<std::pair<std::string, Map>> maps{
+    {"Santa Fe", Map{check::source("test/santa-fe-trail.dat"), 600}},
+    {"5x3", random_map(5, 3, 0.5, 200)},
+    {"37x91", random_map(37, 91, 0.2, 400)},
+    {"400x300", random_map(400, 300, 0.1, 2000)}};
+
+  int compiled{0};
+  for (int i{0}; i < 300; ++i)
+    {
+      const Method method = i % 2 ? Method::grow : Method::full;
+      const Ant::Node root{method, 1 + i % 8, 0};
+      const auto program = jit::compile(root);
+      expect(static_cast<bool>(program), "program " + to_string(i) + " compiles");
+      if (not program)
+	{ continue; }
+      ++compiled;
+      for (const auto& map : maps)
+	{
+	  const int expected = interpret(root, map.second);
+	  const int actual = native(*program, map.second);
+	  expect(actual == expected, "program " + to_string(i) + " on "
+		 + map.first + " scored " + to_string(actual)
+		 + " compiled but " + to_string(expected) + " interpreted");
+	}
+    }
+  expect(compiled > 0, "some programs were compiled");
+  return check::status();
+}
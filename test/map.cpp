@@ -0,0 +1,206 @@
+/* map.cpp - CS 472 Project #3: Genetic Programming
+ * Copyright 2014 Andrew Schwartzmeyer
+ *
+ * Tests of the map kernel: the ant's movement, wraparound on the
+ * torus, food across tile boundaries, and Koza's Santa Fe solution
+ */
+
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "generator/generator.hpp"
+#include "options/options.hpp"
+
+namespace
+{
+  using check::expect;
+  using options::Cell;
+  using options::Map;
+  using std::to_string;
+  typedef std::vector<std::vector<Cell>> Grid;
+
+  // A blank grid of the given size with food at each (x, y).
+  Grid
+  grid(std::size_t width, std::size_t height,
+       const std::vector<std::pair<std::size_t, std::size_t>>& food)
+  {
+    Grid cells(height, std::vector<Cell>(width, Cell::blank));
+    for (const auto& f : food)
+      { cells[f.second][f.first] = Cell::food; }
+    return cells;
+  }
+
+  /* Koza's solution to the Santa Fe trail, each primitive acting only
+     while the ant has ticks left, as the interpreter's do:
+     (if-food-ahead move (prog3 left (prog2 (if-food-ahead move right)
+     (prog2 right (prog2 left right))) (prog2 (if-food-ahead move left)
+     move))) */
+  void
+  koza(Map& map)
+  {
+    auto act = [&map](void (Map::*action)())
+      {
+	if (map.active())
+	  { (map.*action)(); }
+      };
+    auto if_food = [&map](void (Map::*then)(), void (Map::*otherwise)())
+      {
+	if (map.active())
+	  { (map.*(map.look() ? then : otherwise))(); }
+      };
+    if (map.look())
+      {
+	map.forward();
+	return;
+      }
+    act(&Map::left);
+    if_food(&Map::forward, &Map::right);
+    act(&Map::right);
+    act(&Map::left);
+    act(&Map::right);
+    if_food(&Map::forward, &Map::left);
+    act(&Map::forward);
+  }
+
+  void
+  santa_fe()
+  {
+    Map map{check::source("test/santa-fe-trail.dat"), 600};
+    expect(map.max() == 89, "Santa Fe trail has 89 pieces of food");
+    while (map.active())
+      { koza(map); }
+    expect(map.fitness() == 89, "Koza's program eats 89 of 89, not "
+	   + to_string(map.fitness()));
+  }
+
+  // The ant starts at the origin facing east, and moves a cell per tick.
+  void
+  east()
+  {
+    Map map{grid(8, 4, {{1, 0}, {2, 0}, {4, 0}}), 100};
+    expect(map.look(), "food is seen east of the origin");
+    map.forward();
+    map.forward();
+    expect(map.fitness() == 2, "moving east eats (1, 0) and (2, 0)");
+    expect(not map.look(), "no food is seen at (3, 0)");
+    map.forward();
+    expect(map.look(), "food is seen at (4, 0)");
+    expect(map.get_ticks() == 3, "each move takes a tick");
+    map.left();
+    map.right();
+    map.forward();
+    expect(map.fitness() == 3, "turning back east and moving eats (4, 0)");
+  }
+
+  /* Stepping west or north from the origin wraps to the far column or
+     row, on a map whose sides are not powers of two. */
+  void
+  wraparound(std::size_t width, std::size_t height)
+  {
+    const std::string size = to_string(width) + "x" + to_string(height);
+    Map west{grid(width, height, {{width - 1, 0}}), 100};
+    west.left(); // North
+    west.left(); // West
+    expect(west.look(), "food is seen west across the edge of " + size);
+    west.forward();
+    expect(west.fitness() == 1, "moving west wraps to the last column of " + size);
+
+    Map north{grid(width, height, {{0, height - 1}}), 100};
+    north.left(); // North
+    expect(north.look(), "food is seen north across the edge of " + size);
+    north.forward();
+    expect(north.fitness() == 1, "moving north wraps to the last row of " + size);
+
+    // Once around each way eats it no more than once.
+    for (std::size_t i{1}; i < height; ++i)
+      { north.forward(); }
+    expect(north.fitness() == 1, "a lap north of " + size + " returns home");
+    north.forward();
+    expect(north.fitness() == 1, "eaten food is not eaten again on " + size);
+  }
+
+  /* Food on either side of 64-cell tile boundaries, on maps whose
+     visited cells are a bitset (small) or a hash table (large). */
+  void
+  tile_boundaries(std::size_t width, std::size_t height)
+  {
+    const std::string size = to_string(width) + "x" + to_string(height);
+    const std::vector<std::pair<std::size_t, std::size_t>> food{
+      {63, 0}, {64, 0}, {127, 0}, {128, 0}, {0, 63}, {0, 64}, {0, 127},
+      {0, 128}, {64, 64}, {width - 1, height - 1}};
+    const Map map{grid(width, height, food), 1000};
+    const auto tiles = std::make_shared<const options::Tiles>(grid(width, height, food));
+    for (const auto& f : food)
+      {
+	const std::string cell = "(" + to_string(f.first) + ", "
+	  + to_string(f.second) + ") of " + size;
+	expect(tiles->food(f.first, f.second), "food at " + cell);
+	if (f.first > 0)
+	  {
+	    expect(not tiles->food(f.first - 1, f.second)
+		   or f.first == 64 or f.first == 128,
+		   "no food left of " + cell);
+	  }
+	if (f.first + 1 < width and f.first != 63 and f.first != 127)
+	  { expect(not tiles->food(f.first + 1, f.second), "no food right of " + cell); }
+      }
+    expect(map.max() == static_cast<int>(food.size()), "food is counted on " + size);
+
+    // East along the first row, then south along the first column.
+    Map walker = map;
+    for (std::size_t x{0}; x < 130; ++x)
+      { walker.forward(); }
+    expect(walker.fitness() == 4, "walking east eats across tiles on " + size);
+    Map down = map;
+    down.right(); // South
+    for (std::size_t y{0}; y < 130; ++y)
+      { down.forward(); }
+    expect(down.fitness() == 4, "walking south eats across tiles on " + size);
+  }
+
+  // A generated trail's map has food exactly where its grid does.
+  void
+  generated()
+  {
+    generator::Parameters p;
+    p.width = 150;
+    p.height = 70;
+    p.seed = 7;
+    const generator::grid_t rows = generator::trail(p);
+    const options::Tiles tiles{rows};
+    int pieces{0};
+    bool same{true};
+    for (std::size_t y{0}; y < p.height; ++y)
+      for (std::size_t x{0}; x < p.width; ++x)
+	{
+	  pieces += rows[y][x];
+	  same = same and tiles.food(x, y) == rows[y][x];
+	}
+    expect(same, "generated tiles have food where the trail does");
+    expect(pieces > 0 and generator::map(p, 100).max() == pieces,
+	   "a generated map counts the trail's food");
+
+    // Its traces name it exactly, for replays to generate it again.
+    generator::Parameters parsed;
+    const std::string source = generator::map(p, 100).print(options::Trace{});
+    expect(generator::parse(source.substr(4, source.find('\n') - 4), parsed)
+	   and generator::trail(parsed) == rows,
+	   "a generated map's trace names its parameters");
+    expect(not generator::parse("test/santa-fe-trail.dat", parsed),
+	   "a map file is not a generated trail");
+  }
+}
+
+int
+main()
+{
+  santa_fe();
+  east();
+  wraparound(5, 3);
+  wraparound(37, 91);
+  tile_boundaries(200, 150); // Visited as a bitset.
+  tile_boundaries(400, 300); // Visited as a hash table.
+  generated();
+  return check::status();
+}